@@ -10,7 +10,8 @@ pushd %projdir%\build
 ::
 
 :: Preproc flags
-:: -DINTERNAL_BUILD : is it debug build?
+:: -DINTERNAL_BUILD   : is it debug build?
+:: -DLOGO_EXPORT_PNG  : also write cached logos as png next to the cache files
 set cplflags=-DINTERNAL_BUILD=1
 
 :: Optimization flags
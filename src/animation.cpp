@@ -0,0 +1,152 @@
+static f32 ease(Easing easing, f32 t)
+{
+    f32 result = t;
+    switch (easing)
+    {
+        case Easing_Linear:
+        {
+            result = t;
+        } break;
+
+        case Easing_InCubic:
+        {
+            result = t * t * t;
+        } break;
+
+        case Easing_OutCubic:
+        {
+            f32 inv_t = 1.0f - t;
+            result = 1.0f - inv_t * inv_t * inv_t;
+        } break;
+
+        case Easing_InOutCubic:
+        {
+            if (t < 0.5f)
+            {
+                result = 4.0f * t * t * t;
+            }
+            else
+            {
+                f32 inv_t = 2.0f - 2.0f * t;
+                result = 1.0f - 0.5f * inv_t * inv_t * inv_t;
+            }
+        } break;
+    }
+    return result;
+}
+
+static void init_animator(Animator *animator, u32 frames_per_second)
+{
+    animator->frame_interval = 1.0 / (f64)frames_per_second;
+    animator->last_frame = 0;
+    animator->frames = 0;
+    animator->num_animations = 0;
+}
+
+static void update_animation(Animation *animation, f64 now)
+{
+    f32 t = 1.0f;
+    if (now < animation->start)
+    {
+        t = 0.0f;
+    }
+    else if ((animation->duration > 0) && (now < animation->start + animation->duration))
+    {
+        t = (f32)((now - animation->start) / animation->duration);
+    }
+
+    animation->value = animation->from + (animation->to - animation->from) * ease(animation->easing, t);
+    animation->finished = (t >= 1.0f);
+}
+
+// NOTE(dan): restarting an animation that is already running just moves it
+static void start_animation(Animator *animator, Animation *animation, f64 now, f64 delay, f64 duration,
+                            f32 from, f32 to, Easing easing)
+{
+    animation->start = now + delay;
+    animation->duration = duration;
+    animation->from = from;
+    animation->to = to;
+    animation->easing = easing;
+    update_animation(animation, now);
+
+    b32 registered = false;
+    for (u32 animation_index = 0; animation_index < animator->num_animations; ++animation_index)
+    {
+        if (animator->animations[animation_index] == animation)
+        {
+            registered = true;
+            break;
+        }
+    }
+
+    if (!registered)
+    {
+        assert(animator->num_animations < ANIMATION_MAX);
+        animator->animations[animator->num_animations++] = animation;
+    }
+}
+
+static void stop_animation(Animator *animator, Animation *animation)
+{
+    for (u32 animation_index = 0; animation_index < animator->num_animations; ++animation_index)
+    {
+        if (animator->animations[animation_index] == animation)
+        {
+            animator->animations[animation_index] = animator->animations[--animator->num_animations];
+            break;
+        }
+    }
+}
+
+// NOTE(dan): advances every animation to now, finished ones are dropped after
+// their last value was computed
+static void animate(Animator *animator, f64 now)
+{
+    animator->last_frame = now;
+    ++animator->frames;
+
+    for (u32 animation_index = 0; animation_index < animator->num_animations;)
+    {
+        Animation *animation = animator->animations[animation_index];
+        update_animation(animation, now);
+
+        if (animation->finished)
+        {
+            animator->animations[animation_index] = animator->animations[--animator->num_animations];
+        }
+        else
+        {
+            ++animation_index;
+        }
+    }
+}
+
+// NOTE(dan): seconds until the next frame is due, negative when nothing is left to animate.
+// delayed animations sleep until they start instead of ticking
+static f64 get_next_animation_frame(Animator *animator, f64 now)
+{
+    f64 next_frame = -1.0;
+    for (u32 animation_index = 0; animation_index < animator->num_animations; ++animation_index)
+    {
+        Animation *animation = animator->animations[animation_index];
+
+        f64 wake_at = animation->start;
+        if (now >= animation->start)
+        {
+            wake_at = animator->last_frame + animator->frame_interval;
+        }
+
+        f64 wait = wake_at - now;
+        if (wait < 0)
+        {
+            wait = 0;
+        }
+
+        if ((next_frame < 0) || (wait < next_frame))
+        {
+            next_frame = wait;
+        }
+    }
+    return next_frame;
+}
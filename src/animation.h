@@ -0,0 +1,36 @@
+// NOTE(dan): animations are driven by elapsed time, not by ticks. every running
+// animation is advanced by the same frame, and frames are capped to a target rate,
+// so the platform only has to wake up once per frame while something moves
+
+#define ANIMATION_MAX               16
+#define ANIMATION_DEFAULT_FPS       60
+
+enum Easing
+{
+    Easing_Linear,
+    Easing_InCubic,
+    Easing_OutCubic,
+    Easing_InOutCubic,
+};
+
+struct Animation
+{
+    f64 start;      // NOTE(dan): in monotonic seconds, may be in the future
+    f64 duration;
+    f32 from;
+    f32 to;
+    Easing easing;
+
+    f32 value;
+    b32 finished;
+};
+
+struct Animator
+{
+    f64 frame_interval;
+    f64 last_frame;
+
+    u32 frames;
+    u32 num_animations;
+    Animation *animations[ANIMATION_MAX];
+};
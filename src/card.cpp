@@ -0,0 +1,267 @@
+inline Bitmap get_logo_bitmap(Logo *logo)
+{
+    Bitmap result;
+    result.width = (i32)logo->width;
+    result.height = (i32)logo->height;
+    result.pitch = (i32)logo->width * 4;
+    result.memory = (u8 *)logo->pixels;
+    return result;
+}
+
+inline CardTheme get_default_card_theme()
+{
+    CardTheme theme;
+    theme.background_color = CARD_BACKGROUND_COLOR;
+    theme.corner_color = CARD_CORNER_COLOR;
+    theme.header_color = CARD_HEADER_COLOR;
+    theme.message_color = CARD_MESSAGE_COLOR;
+    return theme;
+}
+
+static void render_card_background(Bitmap *bitmap, CardTheme *theme)
+{
+    draw_rectangle(bitmap, 0, 0, bitmap->width, bitmap->height, theme->background_color);
+
+    // NOTE(dan): garbage stuff just for my OCD
+    round_corners(bitmap, 0, 0, bitmap->width, bitmap->height, 0x00000000, theme->corner_color);
+}
+
+static void render_card_content(Bitmap *bitmap, GlyphAtlas *atlas, CardTheme *theme, char *header, char *message, Logo *logo)
+{
+    i32 text_max_x = bitmap->width - CARD_PADDING;
+    i32 header_y = CARD_PADDING;
+    i32 message_y = header_y + atlas->fonts[FontId_Message].height + CARD_PADDING;
+
+    draw_text(bitmap, atlas, FontId_Header, header, CARD_TEXT_X, header_y, text_max_x, theme->header_color);
+    draw_text(bitmap, atlas, FontId_Message, message, CARD_TEXT_X, message_y, text_max_x, theme->message_color);
+
+    if (logo)
+    {
+        Bitmap logo_bitmap = get_logo_bitmap(logo);
+        draw_bitmap(bitmap, &logo_bitmap, CARD_PADDING, CARD_PADDING, 255);
+
+        i32 logo_width = logo_bitmap.width;
+        i32 logo_height = logo_bitmap.height;
+        if (logo_width > bitmap->width - CARD_PADDING)
+        {
+            logo_width = bitmap->width - CARD_PADDING;
+        }
+        if (logo_height > bitmap->height - CARD_PADDING)
+        {
+            logo_height = bitmap->height - CARD_PADDING;
+        }
+        round_corners(bitmap, CARD_PADDING, CARD_PADDING, logo_width, logo_height, theme->background_color, theme->corner_color);
+    }
+}
+
+inline u32 get_card_cache_memory_size(i32 width, i32 height)
+{
+    u32 size = (1 + CARD_CACHE_MAX_CARDS) * width * height * 4;
+    return size;
+}
+
+// NOTE(dan): memory has to be get_card_cache_memory_size(width, height) bytes. cached
+// cards use the pitch of the bitmap they will be copied into, so a copy is a single memcpy
+static void init_card_cache(CardCache *cache, void *memory, i32 width, i32 height, i32 pitch, CardTheme theme)
+{
+    u32 bitmap_size = width * height * 4;
+    i32 top_row_offset = (pitch < 0) ? (height - 1) * -pitch : 0;
+
+    u8 *at = (u8 *)memory;
+    Bitmap *bitmaps[1 + CARD_CACHE_MAX_CARDS];
+    bitmaps[0] = &cache->card_template;
+    for (u32 card_index = 0; card_index < CARD_CACHE_MAX_CARDS; ++card_index)
+    {
+        bitmaps[1 + card_index] = &cache->cards[card_index].bitmap;
+    }
+
+    for (u32 bitmap_index = 0; bitmap_index < array_count(bitmaps); ++bitmap_index)
+    {
+        Bitmap *bitmap = bitmaps[bitmap_index];
+        bitmap->width = width;
+        bitmap->height = height;
+        bitmap->pitch = pitch;
+        bitmap->memory = at + top_row_offset;
+        at += bitmap_size;
+    }
+
+    for (u32 card_index = 0; card_index < CARD_CACHE_MAX_CARDS; ++card_index)
+    {
+        cache->cards[card_index].used = false;
+    }
+
+    cache->theme = theme;
+    render_card_background(&cache->card_template, &cache->theme);
+}
+
+// NOTE(dan): called when a logo changed on disk, cards showing it have to be redrawn
+static void invalidate_cached_cards(CardCache *cache, u32 logo_hash)
+{
+    begin_ticket_mutex(&cache->mutex);
+    for (u32 card_index = 0; card_index < CARD_CACHE_MAX_CARDS; ++card_index)
+    {
+        CachedCard *card = cache->cards + card_index;
+        if (card->used && (card->logo_hash == logo_hash))
+        {
+            card->used = false;
+        }
+    }
+    end_ticket_mutex(&cache->mutex);
+}
+
+// NOTE(dan): every card_cache_* call has to be between begin and end
+inline void begin_card_cache(CardCache *cache)
+{
+    begin_ticket_mutex(&cache->mutex);
+}
+
+inline void end_card_cache(CardCache *cache)
+{
+    end_ticket_mutex(&cache->mutex);
+}
+
+// NOTE(dan): returns whether the card was in the cache and copied into bitmap
+static b32 card_cache_copy(CardCache *cache, Bitmap *bitmap, char *title, char *message, u32 logo_hash)
+{
+    b32 found = false;
+    for (u32 card_index = 0; card_index < CARD_CACHE_MAX_CARDS; ++card_index)
+    {
+        CachedCard *card = cache->cards + card_index;
+        if (card->used && (card->logo_hash == logo_hash) &&
+            strings_equal(card->title, title) && strings_equal(card->message, message))
+        {
+            card->last_used = ++cache->use_clock;
+            copy_bitmap(bitmap, &card->bitmap);
+            found = true;
+            break;
+        }
+    }
+
+    if (found)
+    {
+        ++cache->hits;
+    }
+    else
+    {
+        ++cache->misses;
+    }
+    return found;
+}
+
+// NOTE(dan): renders the card into bitmap starting from the template, and keeps it
+// unless it has no logo yet or its strings don't fit
+static void card_cache_render(CardCache *cache, Bitmap *bitmap, GlyphAtlas *atlas, char *title, char *message, u32 logo_hash, Logo *logo)
+{
+    CachedCard *card = 0;
+    if (logo && (string_length(title) < array_count(card->title)) && (string_length(message) < array_count(card->message)))
+    {
+        card = cache->cards;
+        for (u32 card_index = 0; card_index < CARD_CACHE_MAX_CARDS; ++card_index)
+        {
+            CachedCard *test_card = cache->cards + card_index;
+            if (!test_card->used)
+            {
+                card = test_card;
+                break;
+            }
+            if (test_card->last_used < card->last_used)
+            {
+                card = test_card;
+            }
+        }
+    }
+
+    if (card)
+    {
+        copy_bitmap(&card->bitmap, &cache->card_template);
+        render_card_content(&card->bitmap, atlas, &cache->theme, title, message, logo);
+
+        card->used = true;
+        card->logo_hash = logo_hash;
+        card->last_used = ++cache->use_clock;
+        copy_string(title, card->title);
+        copy_string(message, card->message);
+
+        copy_bitmap(bitmap, &card->bitmap);
+    }
+    else
+    {
+        copy_bitmap(bitmap, &cache->card_template);
+        render_card_content(bitmap, atlas, &cache->theme, title, message, logo);
+    }
+}
+
+static void push_notifications(CardStack *stack, Notification *notifications, u32 count)
+{
+    if (count >= CARD_STACK_MAX_CARDS)
+    {
+        // NOTE(dan): the whole stack goes to this burst, the rest is summed up
+        stack->num_cards = 0;
+        for (u32 notification_index = 0; notification_index < CARD_STACK_MAX_CARDS - 1; ++notification_index)
+        {
+            stack->cards[stack->num_cards++] = notifications[notification_index];
+        }
+
+        if (count == CARD_STACK_MAX_CARDS)
+        {
+            stack->cards[stack->num_cards++] = notifications[count - 1];
+        }
+        else
+        {
+            Notification *summary = stack->cards + stack->num_cards++;
+            snprintf(summary->title, array_count(summary->title), "%u more started streaming", count - (CARD_STACK_MAX_CARDS - 1));
+            snprintf(summary->message, array_count(summary->message), "See the tray menu for the list");
+            summary->logo_hash = 0;
+        }
+    }
+    else
+    {
+        // NOTE(dan): oldest cards make room
+        u32 keep = CARD_STACK_MAX_CARDS - count;
+        if (stack->num_cards > keep)
+        {
+            u32 drop = stack->num_cards - keep;
+            for (u32 card_index = 0; card_index < keep; ++card_index)
+            {
+                stack->cards[card_index] = stack->cards[card_index + drop];
+            }
+            stack->num_cards = keep;
+        }
+
+        for (u32 notification_index = 0; notification_index < count; ++notification_index)
+        {
+            stack->cards[stack->num_cards++] = notifications[notification_index];
+        }
+    }
+}
+
+inline i32 get_card_stack_height(CardStack *stack)
+{
+    i32 height = 0;
+    if (stack->num_cards)
+    {
+        height = (i32)stack->num_cards * (CARD_HEIGHT + CARD_STACK_GAP) - CARD_STACK_GAP;
+    }
+    return height;
+}
+
+// NOTE(dan): a view of the surface where the card goes, it shares the surface's memory
+inline Bitmap get_stacked_card_bitmap(Bitmap *surface, u32 card_index)
+{
+    Bitmap result;
+    result.width = CARD_WIDTH;
+    result.height = CARD_HEIGHT;
+    result.pitch = surface->pitch;
+    result.memory = surface->memory + (i32)card_index * (CARD_HEIGHT + CARD_STACK_GAP) * surface->pitch;
+    return result;
+}
+
+// NOTE(dan): the gaps between the cards have to be see-through
+static void clear_card_stack_gaps(Bitmap *surface, CardStack *stack)
+{
+    for (u32 card_index = 1; card_index < stack->num_cards; ++card_index)
+    {
+        i32 gap_y = (i32)card_index * (CARD_HEIGHT + CARD_STACK_GAP) - CARD_STACK_GAP;
+        draw_rectangle(surface, 0, gap_y, surface->width, gap_y + CARD_STACK_GAP, 0x00000000);
+    }
+}
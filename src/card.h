@@ -0,0 +1,59 @@
+// NOTE(dan): a notification card is the logo on the left and two lines of
+// text, drawn with the software renderer
+
+#define CARD_BACKGROUND_COLOR   0xFFFFFFFF
+#define CARD_CORNER_COLOR       0x60D6DADB
+#define CARD_HEADER_COLOR       0xFF454545
+#define CARD_MESSAGE_COLOR      0xFF878787
+#define CARD_PADDING            10
+#define CARD_TEXT_X             80
+
+struct CardTheme
+{
+    u32 background_color;
+    u32 corner_color;
+    u32 header_color;
+    u32 message_color;
+};
+
+// NOTE(dan): the background and the corners are rendered once per size and
+// theme into a template, fully rendered cards are kept for repeated notifications
+#define CARD_CACHE_MAX_CARDS    16
+
+struct CachedCard
+{
+    b32 used;
+    u32 logo_hash;
+    u64 last_used;
+    char title[64];
+    char message[256];
+    Bitmap bitmap;
+};
+
+struct CardCache
+{
+    TicketMutex mutex;
+
+    CardTheme theme;
+    Bitmap card_template;
+
+    u64 use_clock;
+    u32 hits;
+    u32 misses;
+
+    CachedCard cards[CARD_CACHE_MAX_CARDS];
+};
+
+// NOTE(dan): cards shown at the same time are stacked, oldest on top. a burst
+// bigger than the stack ends in a summary card instead of pushing everything out
+#define CARD_WIDTH              320
+#define CARD_HEIGHT             80
+#define CARD_STACK_MAX_CARDS    5
+#define CARD_STACK_GAP          8
+#define CARD_STACK_MAX_HEIGHT   (CARD_STACK_MAX_CARDS * (CARD_HEIGHT + CARD_STACK_GAP) - CARD_STACK_GAP)
+
+struct CardStack
+{
+    u32 num_cards;
+    Notification cards[CARD_STACK_MAX_CARDS];
+};
@@ -0,0 +1,71 @@
+// NOTE(dan): returns the consumer index, a new consumer sees the events logged after it registered
+static u32 register_transition_consumer(TransitionLog *log)
+{
+    assert(log->num_consumers < MAX_TRANSITION_CONSUMERS);
+
+    u32 consumer_index = log->num_consumers++;
+    TransitionConsumer *consumer = log->consumers + consumer_index;
+    consumer->read_index = log->write_index;
+    consumer->wake_pending = false;
+    return consumer_index;
+}
+
+// NOTE(dan): producer side, returns false when the slowest consumer is a whole log behind
+static b32 push_transition_event(TransitionLog *log, TransitionEvent *event)
+{
+    b32 pushed = false;
+
+    u32 write_index = log->write_index;
+
+    b32 full = false;
+    for (u32 consumer_index = 0; consumer_index < log->num_consumers; ++consumer_index)
+    {
+        if (write_index - log->consumers[consumer_index].read_index >= TRANSITION_LOG_SIZE)
+        {
+            full = true;
+            break;
+        }
+    }
+
+    if (!full)
+    {
+        log->events[write_index & (TRANSITION_LOG_SIZE - 1)] = *event;
+
+        complete_previous_writes_before_future_writes;
+        log->write_index = write_index + 1;
+        pushed = true;
+    }
+    return pushed;
+}
+
+// NOTE(dan): consumer side, returns false when the consumer has read everything
+static b32 pop_transition_event(TransitionLog *log, u32 consumer_index, TransitionEvent *event)
+{
+    b32 popped = false;
+
+    TransitionConsumer *consumer = log->consumers + consumer_index;
+    u32 read_index = consumer->read_index;
+    if (read_index != log->write_index)
+    {
+        complete_previous_reads_before_future_reads;
+        *event = log->events[read_index & (TRANSITION_LOG_SIZE - 1)];
+
+        complete_previous_writes_before_future_writes;
+        consumer->read_index = read_index + 1;
+        popped = true;
+    }
+    return popped;
+}
+
+// NOTE(dan): producer side, returns whether the consumer has to be woken up
+inline b32 request_transition_wake(TransitionLog *log, u32 consumer_index)
+{
+    b32 wake = (atomic_compare_exchange_u32(&log->consumers[consumer_index].wake_pending, 1, 0) == 0);
+    return wake;
+}
+
+// NOTE(dan): consumer side, before draining, so events logged meanwhile wake it again
+inline void begin_transition_drain(TransitionLog *log, u32 consumer_index)
+{
+    atomic_compare_exchange_u32(&log->consumers[consumer_index].wake_pending, 0, 1);
+}
@@ -0,0 +1,48 @@
+// NOTE(dan): the update thread diffs the stream states it publishes and logs every
+// transition into a bounded ring. any number of consumers, up to the maximum, read
+// the log at their own pace through their own read index, and the producer never
+// overwrites an event some consumer hasn't read yet. consumers register before the
+// update thread starts
+#define TRANSITION_LOG_SIZE         128 // NOTE(dan): has to be a power of two
+#define MAX_TRANSITION_CONSUMERS    4
+
+enum TransitionEventType
+{
+    TransitionEventType_WentOnline,
+    TransitionEventType_WentOffline,
+    TransitionEventType_GameChanged,
+    TransitionEventType_TitleChanged,
+    TransitionEventType_CycleEnd,
+};
+
+struct TransitionEvent
+{
+    TransitionEventType type;
+    u32 stream_index;
+    u64 time;   // NOTE(dan): unix seconds of the cycle that saw it
+
+    char game[128];
+    char title[256];
+
+    b32 has_notification;
+    Notification notification;
+};
+
+struct TransitionConsumer
+{
+    u32 volatile read_index;
+
+    // NOTE(dan): set while a wake-up is on its way, so a burst only wakes the consumer once
+    u32 volatile wake_pending;
+
+    u8 padding[56]; // NOTE(dan): one cache line per consumer
+};
+
+struct TransitionLog
+{
+    u32 volatile write_index;
+    u32 num_consumers;
+    TransitionConsumer consumers[MAX_TRANSITION_CONSUMERS];
+
+    TransitionEvent events[TRANSITION_LOG_SIZE];
+};
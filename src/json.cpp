@@ -230,6 +230,12 @@ static i32 json_parse(JsonParser *parser, char *json_string, u32 json_string_len
             } break;
         }
     }
+
+    // NOTE(dan): only a closed root means the whole document was there
+    if (parser->status == JsonParserStatus_Initialized && parser->num_tokens && parser->token_array[0].end != -1)
+    {
+        parser->status = JsonParserStatus_Success;
+    }
     return num_tokens_found;
 }
 
@@ -0,0 +1,390 @@
+
+inline u32 logo_checksum(void *data, u32 size)
+{
+    // NOTE(dan): fnv-1a
+    u32 hash = 2166136261;
+    u8 *at = (u8 *)data;
+    for (u32 byte_index = 0; byte_index < size; ++byte_index)
+    {
+        hash ^= at[byte_index];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+inline u32 get_logo_file_size(u32 width, u32 height)
+{
+    u32 size = sizeof(LogoFileHeader) + width * height * sizeof(u32);
+    return size;
+}
+
+static u64 get_logo_expiry(u32 logo_hash, u64 now)
+{
+    // NOTE(dan): xorshift on the hash and the time, so a logo refreshed twice gets a different spread
+    u64 x = ((u64)logo_hash << 32) ^ now ^ 0x9E3779B97F4A7C15ULL;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    u64 jitter = x % (2 * LOGO_EXPIRES_JITTER_SECS);
+    u64 expires = now + LOGO_EXPIRES_SECS - LOGO_EXPIRES_JITTER_SECS + jitter;
+    return expires;
+}
+
+inline b32 logo_expired(Logo *logo, u64 now)
+{
+    b32 expired = (logo->header->expires <= now);
+    return expired;
+}
+
+// NOTE(dan): file_memory has to be get_logo_file_size(width, height) bytes,
+// image is the decoded logo with 1 to 4 interleaved channels
+static void write_logo_file(void *file_memory, u8 *image, u32 channels, u32 width, u32 height, u64 expires, LogoValidators *validators)
+{
+    LogoFileHeader *header = (LogoFileHeader *)file_memory;
+    u32 *pixels = (u32 *)(header + 1);
+
+    convert_to_premultiplied_bgra(pixels, image, channels, width * height);
+
+    header->magic = LOGO_FILE_MAGIC;
+    header->version = LOGO_FILE_VERSION;
+    header->expires = expires;
+    header->width = width;
+    header->height = height;
+    header->checksum = logo_checksum(pixels, width * height * sizeof(u32));
+    header->validators = *validators;
+}
+
+static b32 parse_logo_file(void *contents, u32 size, Logo *logo)
+{
+    b32 valid = false;
+    LogoFileHeader *header = (LogoFileHeader *)contents;
+    if (contents && size >= sizeof(LogoFileHeader) &&
+        header->magic == LOGO_FILE_MAGIC &&
+        header->version == LOGO_FILE_VERSION &&
+        header->width <= 1024 && header->height <= 1024 &&
+        size == get_logo_file_size(header->width, header->height))
+    {
+        u32 *pixels = (u32 *)(header + 1);
+        if (header->checksum == logo_checksum(pixels, header->width * header->height * sizeof(u32)))
+        {
+            header->validators.etag[array_count(header->validators.etag) - 1] = 0;
+            header->validators.last_modified[array_count(header->validators.last_modified) - 1] = 0;
+
+            logo->header = header;
+            logo->width = header->width;
+            logo->height = header->height;
+            logo->pixels = pixels;
+            valid = true;
+        }
+    }
+    return valid;
+}
+
+static void init_logo_cache(LogoCache *cache, u64 max_bytes, u32 max_entries)
+{
+    cache->max_bytes = max_bytes;
+    cache->max_entries = (max_entries < LOGO_CACHE_MAX_ENTRIES) ? max_entries : LOGO_CACHE_MAX_ENTRIES;
+    cache->num_entries = 0;
+    cache->num_displaced = 0;
+    cache->total_bytes = 0;
+    cache->use_clock = 0;
+    cache->renders_in_progress = 0;
+    cache->dirty = false;
+}
+
+static LogoCacheEntry *find_logo_cache_entry(LogoCache *cache, u32 logo_hash)
+{
+    LogoCacheEntry *entry = 0;
+    for (u32 entry_index = 0; entry_index < cache->num_entries; ++entry_index)
+    {
+        LogoCacheEntry *test_entry = cache->entries + entry_index;
+        if (test_entry->logo_hash == logo_hash)
+        {
+            entry = test_entry;
+            break;
+        }
+    }
+    return entry;
+}
+
+static void remove_logo_cache_entry(LogoCache *cache, LogoCacheEntry *entry)
+{
+    assert(cache->total_bytes >= entry->size);
+    cache->total_bytes -= entry->size;
+    *entry = cache->entries[--cache->num_entries];
+    cache->dirty = true;
+}
+
+static LogoCacheEntry *find_least_recently_used_logo(LogoCache *cache)
+{
+    LogoCacheEntry *victim = cache->entries;
+    for (u32 entry_index = 1; entry_index < cache->num_entries; ++entry_index)
+    {
+        LogoCacheEntry *entry = cache->entries + entry_index;
+        if (entry->last_used < victim->last_used)
+        {
+            victim = entry;
+        }
+    }
+    return victim;
+}
+
+// NOTE(dan): if the queue is full the file stays on disk untracked until the next
+// startup, which finds it and queues it again
+static void queue_displaced_logo(LogoCache *cache, u32 logo_hash)
+{
+    if (cache->num_displaced < array_count(cache->displaced))
+    {
+        cache->displaced[cache->num_displaced++] = logo_hash;
+    }
+}
+
+// NOTE(dan): the entry table is bigger than any sane budget, but if it does fill
+// up the least recently used entry gives up its slot and is evicted as usual
+static void add_logo_cache_entry(LogoCache *cache, u32 logo_hash, u32 size, u64 last_used)
+{
+    // NOTE(dan): a logo cached again before its file was deleted keeps the file
+    for (u32 displaced_index = 0; displaced_index < cache->num_displaced; ++displaced_index)
+    {
+        if (cache->displaced[displaced_index] == logo_hash)
+        {
+            cache->displaced[displaced_index] = cache->displaced[--cache->num_displaced];
+            break;
+        }
+    }
+
+    if (cache->num_entries == array_count(cache->entries))
+    {
+        LogoCacheEntry *victim = find_least_recently_used_logo(cache);
+
+        ++cache->evictions;
+        cache->evicted_bytes += victim->size;
+
+        queue_displaced_logo(cache, victim->logo_hash);
+        remove_logo_cache_entry(cache, victim);
+    }
+
+    LogoCacheEntry *entry = cache->entries + cache->num_entries++;
+    entry->logo_hash = logo_hash;
+    entry->size = size;
+    entry->last_used = last_used;
+
+    cache->total_bytes += size;
+    cache->dirty = true;
+}
+
+static void logo_cache_insert(LogoCache *cache, u32 logo_hash, u32 size)
+{
+    begin_ticket_mutex(&cache->mutex);
+
+    LogoCacheEntry *entry = find_logo_cache_entry(cache, logo_hash);
+    if (entry)
+    {
+        cache->total_bytes = cache->total_bytes - entry->size + size;
+        entry->size = size;
+        entry->last_used = ++cache->use_clock;
+        cache->dirty = true;
+    }
+    else
+    {
+        add_logo_cache_entry(cache, logo_hash, size, ++cache->use_clock);
+    }
+
+    end_ticket_mutex(&cache->mutex);
+}
+
+// NOTE(dan): nothing is evicted between begin and end render
+static void logo_cache_begin_render(LogoCache *cache, u32 logo_hash)
+{
+    begin_ticket_mutex(&cache->mutex);
+
+    ++cache->renders_in_progress;
+
+    LogoCacheEntry *entry = find_logo_cache_entry(cache, logo_hash);
+    if (entry)
+    {
+        entry->last_used = ++cache->use_clock;
+        cache->dirty = true;
+        ++cache->hits;
+    }
+    else
+    {
+        ++cache->misses;
+    }
+
+    end_ticket_mutex(&cache->mutex);
+}
+
+static void logo_cache_end_render(LogoCache *cache)
+{
+    begin_ticket_mutex(&cache->mutex);
+
+    assert(cache->renders_in_progress > 0);
+    --cache->renders_in_progress;
+
+    end_ticket_mutex(&cache->mutex);
+}
+
+inline b32 logo_cache_over_budget(LogoCache *cache)
+{
+    b32 over_budget = (cache->total_bytes > cache->max_bytes || cache->num_entries > cache->max_entries);
+    return over_budget;
+}
+
+// NOTE(dan): with the mutex held
+static b32 logo_cache_pop_victim(LogoCache *cache, u32 *logo_hash)
+{
+    b32 popped = false;
+    if (cache->num_displaced)
+    {
+        *logo_hash = cache->displaced[--cache->num_displaced];
+        popped = true;
+    }
+    else if (logo_cache_over_budget(cache) && cache->num_entries)
+    {
+        LogoCacheEntry *victim = find_least_recently_used_logo(cache);
+
+        ++cache->evictions;
+        cache->evicted_bytes += victim->size;
+
+        *logo_hash = victim->logo_hash;
+        remove_logo_cache_entry(cache, victim);
+        popped = true;
+    }
+    return popped;
+}
+
+// NOTE(dan): takes up to max_count logos off the cache whose files have to be deleted,
+// returns how many. the caller deletes the files without holding the mutex. nothing
+// is taken while a notification is being rendered, the eviction is retried next cycle
+static u32 logo_cache_take_victims(LogoCache *cache, u32 *logo_hashes, u32 max_count)
+{
+    u32 count = 0;
+
+    begin_ticket_mutex(&cache->mutex);
+    if (cache->renders_in_progress == 0)
+    {
+        while (count < max_count && logo_cache_pop_victim(cache, logo_hashes + count))
+        {
+            ++count;
+        }
+    }
+    end_ticket_mutex(&cache->mutex);
+
+    return count;
+}
+
+inline b32 logo_cache_is_dirty(LogoCache *cache)
+{
+    begin_ticket_mutex(&cache->mutex);
+    b32 dirty = cache->dirty;
+    end_ticket_mutex(&cache->mutex);
+    return dirty;
+}
+
+inline u32 get_logo_cache_index_size(LogoCache *cache)
+{
+    u32 size = sizeof(LogoCacheIndexHeader) + cache->num_entries * sizeof(LogoCacheEntry);
+    return size;
+}
+
+// NOTE(dan): returns the size written, memory should be LOGO_CACHE_INDEX_MAX_SIZE bytes
+static u32 write_logo_cache_index(LogoCache *cache, void *memory, u32 memory_size)
+{
+    u32 size = 0;
+
+    begin_ticket_mutex(&cache->mutex);
+
+    if (get_logo_cache_index_size(cache) <= memory_size)
+    {
+        LogoCacheIndexHeader *header = (LogoCacheIndexHeader *)memory;
+        LogoCacheEntry *entries = (LogoCacheEntry *)(header + 1);
+
+        for (u32 entry_index = 0; entry_index < cache->num_entries; ++entry_index)
+        {
+            entries[entry_index] = cache->entries[entry_index];
+        }
+
+        header->magic = LOGO_CACHE_INDEX_MAGIC;
+        header->version = LOGO_CACHE_INDEX_VERSION;
+        header->num_entries = cache->num_entries;
+        header->checksum = logo_checksum(entries, cache->num_entries * sizeof(LogoCacheEntry));
+
+        size = get_logo_cache_index_size(cache);
+        cache->dirty = false;
+    }
+
+    end_ticket_mutex(&cache->mutex);
+    return size;
+}
+
+static b32 read_logo_cache_index(LogoCache *cache, void *contents, u32 size)
+{
+    b32 valid = false;
+    LogoCacheIndexHeader *header = (LogoCacheIndexHeader *)contents;
+    if (contents && size >= sizeof(LogoCacheIndexHeader) &&
+        header->magic == LOGO_CACHE_INDEX_MAGIC &&
+        header->version == LOGO_CACHE_INDEX_VERSION &&
+        header->num_entries <= LOGO_CACHE_MAX_ENTRIES &&
+        size == sizeof(LogoCacheIndexHeader) + header->num_entries * sizeof(LogoCacheEntry))
+    {
+        LogoCacheEntry *entries = (LogoCacheEntry *)(header + 1);
+        if (header->checksum == logo_checksum(entries, header->num_entries * sizeof(LogoCacheEntry)))
+        {
+            for (u32 entry_index = 0; entry_index < header->num_entries; ++entry_index)
+            {
+                LogoCacheEntry *entry = entries + entry_index;
+                add_logo_cache_entry(cache, entry->logo_hash, entry->size, entry->last_used);
+
+                if (cache->use_clock < entry->last_used)
+                {
+                    cache->use_clock = entry->last_used;
+                }
+            }
+            cache->dirty = false;
+            valid = true;
+        }
+    }
+    return valid;
+}
+
+// NOTE(dan): files the index doesn't know about (e.g. the index wasn't saved
+// before a crash) are added as least recently used, entries without a file go
+static void reconcile_logo_cache_entry(LogoCache *cache, u32 logo_hash, u32 size, b32 *seen)
+{
+    LogoCacheEntry *entry = find_logo_cache_entry(cache, logo_hash);
+    if (entry)
+    {
+        if (entry->size != size)
+        {
+            cache->total_bytes = cache->total_bytes - entry->size + size;
+            entry->size = size;
+            cache->dirty = true;
+        }
+        seen[entry - cache->entries] = true;
+    }
+    else if (cache->num_entries < array_count(cache->entries))
+    {
+        seen[cache->num_entries] = true;
+        add_logo_cache_entry(cache, logo_hash, size, 0);
+    }
+    else
+    {
+        // NOTE(dan): no slot for it, it's the least recently used there is
+        queue_displaced_logo(cache, logo_hash);
+    }
+}
+
+static void remove_unseen_logo_cache_entries(LogoCache *cache, b32 *seen)
+{
+    for (u32 entry_index = cache->num_entries; entry_index > 0; --entry_index)
+    {
+        if (!seen[entry_index - 1])
+        {
+            // NOTE(dan): the removal moves the last entry here, which was already checked
+            seen[entry_index - 1] = seen[cache->num_entries - 1];
+            remove_logo_cache_entry(cache, cache->entries + entry_index - 1);
+        }
+    }
+}
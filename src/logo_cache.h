@@ -0,0 +1,87 @@
+// NOTE(dan): cached logos are stored in their final format, premultiplied BGRA
+// pixels behind a small header, so showing a notification needs no decoding
+
+#define LOGO_FILE_MAGIC     0x4F474C57 // NOTE(dan): "WLGO"
+#define LOGO_FILE_VERSION   2
+
+// NOTE(dan): a logo is revalidated with the server after about a week, the
+// jitter keeps logos cached on the same day from expiring in the same cycle
+#define LOGO_EXPIRES_DAYS           7
+#define LOGO_EXPIRES_SECS           (LOGO_EXPIRES_DAYS * 24 * 60 * 60)
+#define LOGO_EXPIRES_JITTER_SECS    (24 * 60 * 60)
+
+struct LogoValidators
+{
+    char etag[128];
+    char last_modified[64];
+};
+
+struct LogoFileHeader
+{
+    u32 magic;
+    u32 version;
+    u64 expires;    // NOTE(dan): in platform seconds
+    u32 width;
+    u32 height;
+    u32 checksum;   // NOTE(dan): of the pixels only, so revalidation can rewrite the header alone
+    LogoValidators validators;
+};
+
+struct Logo
+{
+    LogoFileHeader *header;
+    u32 width;
+    u32 height;
+    u32 *pixels;
+};
+
+// NOTE(dan): the cache is kept under a byte and an entry budget, least recently
+// used logos are evicted first. the use order survives restarts in an index file
+#define LOGO_CACHE_INDEX_MAGIC          0x58444C57 // NOTE(dan): "WLDX"
+#define LOGO_CACHE_INDEX_VERSION        1
+#define LOGO_CACHE_MAX_ENTRIES          4096
+#define LOGO_CACHE_DEFAULT_MAX_KB       (4 * 1024)
+#define LOGO_CACHE_DEFAULT_MAX_ENTRIES  256
+#define LOGO_CACHE_MAX_DISPLACED        256 // NOTE(dan): more than a cycle inserts between two eviction passes
+#define LOGO_CACHE_INDEX_MAX_SIZE       (sizeof(LogoCacheIndexHeader) + LOGO_CACHE_MAX_ENTRIES * sizeof(LogoCacheEntry))
+
+struct LogoCacheEntry
+{
+    u32 logo_hash;
+    u32 size;
+    u64 last_used;
+};
+
+struct LogoCacheIndexHeader
+{
+    u32 magic;
+    u32 version;
+    u32 num_entries;
+    u32 checksum;
+};
+
+struct LogoCache
+{
+    TicketMutex mutex;
+
+    u64 max_bytes;
+    u32 max_entries;
+
+    u32 num_entries;
+    u64 total_bytes;
+    u64 use_clock;
+    u32 renders_in_progress;
+    b32 dirty;
+
+    u64 hits;
+    u64 misses;
+    u64 evictions;
+    u64 evicted_bytes;
+
+    // NOTE(dan): entries that lost their slot to a new one when the table was full,
+    // their files are deleted by the next eviction pass
+    u32 num_displaced;
+    u32 displaced[LOGO_CACHE_MAX_DISPLACED];
+
+    LogoCacheEntry entries[LOGO_CACHE_MAX_ENTRIES];
+};
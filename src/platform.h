@@ -38,6 +38,34 @@
     #define ARCH    ARCH_32_BIT
 #endif
 
+// NOTE(dan): snprintf is the only thing the core takes from the CRT, so it builds off Windows
+#include <stdio.h>
+
+#if COMPILER == COMPILER_MSVC && _MSC_VER < 1900
+#include <stdarg.h>
+
+// NOTE(dan): vs2013 only has the underscore one, it doesn't terminate a cut off string
+// and returns -1 for it. this one returns the length the whole string would have
+inline int snprintf(char *buffer, size_t size, char const *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    int length = _vscprintf(format, args);
+    va_end(args);
+
+    if (size)
+    {
+        va_start(args, format);
+        _vsnprintf(buffer, size - 1, format, args);
+        va_end(args);
+
+        buffer[size - 1] = 0;
+    }
+    return length;
+}
+#endif
+
 typedef unsigned char    u8;
 typedef   signed char    i8;
 typedef unsigned short  u16;
@@ -114,28 +142,283 @@ typedef char test_size_usize[sizeof(usize) == sizeof(char *) ? 1 : -1];
 #define GB  (1024LL * MB)
 #define TB  (1024LL * GB)
 
+#if COMPILER == COMPILER_MSVC
+    #include <intrin.h>
+
+    #define complete_previous_writes_before_future_writes   _WriteBarrier(); _mm_sfence()
+    #define complete_previous_reads_before_future_reads     _ReadBarrier()
+    #define yield_processor()                               _mm_pause()
+
+    // NOTE(dan): msvc compiles ssse3 and avx2 intrinsics without any extra flags
+    #define TARGET_SSSE3
+    #define TARGET_AVX2
+
+    inline b32 cpu_supports_ssse3()
+    {
+        int info[4];
+        __cpuid(info, 1);
+
+        b32 result = (info[2] & (1 << 9)) != 0;
+        return result;
+    }
+
+    inline b32 cpu_supports_avx2()
+    {
+        b32 result = false;
+
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] >= 7)
+        {
+            __cpuid(info, 1);
+            b32 avx = (info[2] & (1 << 28)) != 0;
+            b32 osxsave = (info[2] & (1 << 27)) != 0;
+
+            // NOTE(dan): the OS has to save the ymm registers too
+            if (avx && osxsave && ((_xgetbv(0) & 6) == 6))
+            {
+                __cpuidex(info, 7, 0);
+                result = (info[1] & (1 << 5)) != 0;
+            }
+        }
+        return result;
+    }
+
+    inline u32 atomic_compare_exchange_u32(u32 volatile *value, u32 new_value, u32 expected)
+    {
+        u32 result = _InterlockedCompareExchange((long volatile *)value, new_value, expected);
+        return result;
+    }
+
+    inline u32 atomic_add_u32(u32 volatile *value, u32 addend)
+    {
+        // NOTE(dan): returns the original value
+        u32 result = _InterlockedExchangeAdd((long volatile *)value, addend);
+        return result;
+    }
+
+    inline u64 atomic_add_u64(u64 volatile *value, u64 addend)
+    {
+        // NOTE(dan): returns the original value
+        u64 result = _InterlockedExchangeAdd64((__int64 volatile *)value, addend);
+        return result;
+    }
+
+    inline u64 atomic_exchange_u64(u64 volatile *value, u64 new_value)
+    {
+        // NOTE(dan): returns the original value, a full barrier
+        u64 result = _InterlockedExchange64((__int64 volatile *)value, new_value);
+        return result;
+    }
+
+    inline void *atomic_exchange_pointer(void *volatile *value, void *new_value)
+    {
+        void *result = _InterlockedExchangePointer(value, new_value);
+        return result;
+    }
+
+    inline void *atomic_read_pointer(void *volatile *value)
+    {
+        // NOTE(dan): volatile reads have acquire semantics on msvc
+        void *result = *value;
+        _ReadBarrier();
+        return result;
+    }
+#else
+    #include <x86intrin.h>
+    #include <cpuid.h>
+
+    #define complete_previous_writes_before_future_writes   __sync_synchronize()
+    #define complete_previous_reads_before_future_reads     __sync_synchronize()
+    #define yield_processor()                               _mm_pause()
+
+    #define TARGET_SSSE3    __attribute__((target("ssse3")))
+    #define TARGET_AVX2     __attribute__((target("avx2")))
+
+    inline b32 cpu_supports_ssse3()
+    {
+        u32 eax, ebx, ecx, edx;
+        __cpuid(1, eax, ebx, ecx, edx);
+
+        b32 result = (ecx & (1 << 9)) != 0;
+        return result;
+    }
+
+    inline b32 cpu_supports_avx2()
+    {
+        b32 result = false;
+
+        u32 eax, ebx, ecx, edx;
+        __cpuid(0, eax, ebx, ecx, edx);
+        if (eax >= 7)
+        {
+            __cpuid(1, eax, ebx, ecx, edx);
+            b32 avx = (ecx & (1 << 28)) != 0;
+            b32 osxsave = (ecx & (1 << 27)) != 0;
+
+            if (avx && osxsave)
+            {
+                // NOTE(dan): the OS has to save the ymm registers too
+                u32 xcr0_lo, xcr0_hi;
+                __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+                if ((xcr0_lo & 6) == 6)
+                {
+                    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+                    result = (ebx & (1 << 5)) != 0;
+                }
+            }
+        }
+        return result;
+    }
+
+    inline u32 atomic_compare_exchange_u32(u32 volatile *value, u32 new_value, u32 expected)
+    {
+        u32 result = __sync_val_compare_and_swap(value, expected, new_value);
+        return result;
+    }
+
+    inline u32 atomic_add_u32(u32 volatile *value, u32 addend)
+    {
+        // NOTE(dan): returns the original value
+        u32 result = __sync_fetch_and_add(value, addend);
+        return result;
+    }
+
+    inline u64 atomic_add_u64(u64 volatile *value, u64 addend)
+    {
+        // NOTE(dan): returns the original value
+        u64 result = __sync_fetch_and_add(value, addend);
+        return result;
+    }
+
+    inline u64 atomic_exchange_u64(u64 volatile *value, u64 new_value)
+    {
+        // NOTE(dan): returns the original value, a full barrier
+        u64 result = __atomic_exchange_n(value, new_value, __ATOMIC_SEQ_CST);
+        return result;
+    }
+
+    inline void *atomic_exchange_pointer(void *volatile *value, void *new_value)
+    {
+        void *result = __atomic_exchange_n(value, new_value, __ATOMIC_SEQ_CST);
+        return result;
+    }
+
+    inline void *atomic_read_pointer(void *volatile *value)
+    {
+        void *result = __atomic_load_n(value, __ATOMIC_ACQUIRE);
+        return result;
+    }
+#endif
+
+inline void copy_memory(void *dest, void *src, usize size)
+{
+#if COMPILER == COMPILER_MSVC
+    __movsb((unsigned char *)dest, (unsigned char *)src, size);
+#else
+    __builtin_memcpy(dest, src, size);
+#endif
+}
+
+struct TicketMutex
+{
+    u64 volatile ticket;
+    u64 volatile serving;
+};
+
+inline void begin_ticket_mutex(TicketMutex *mutex)
+{
+    u64 ticket = atomic_add_u64(&mutex->ticket, 1);
+    while (ticket != mutex->serving)
+    {
+        yield_processor();
+    }
+}
+
+inline void end_ticket_mutex(TicketMutex *mutex)
+{
+    atomic_add_u64(&mutex->serving, 1);
+}
+
+#define MAX_STREAMS     64 // NOTE(dan): how many channels streams.txt can list
+
 struct LoadedFile
 {
     u32 size;
     void *contents;
 };
 
-#define PLATFORM_SHOW_NOTIFICATION(name)    void name(char *title, char *message, u32 logo_hash)
+// NOTE(dan): a file mapped read-write as a whole
+struct PlatformMappedFile
+{
+    void *memory;
+    u64 size;
+    void *file_handle;
+    void *mapping_handle;
+};
+
+struct Notification
+{
+    char title[64];
+    char message[256];
+    u32 logo_hash;
+};
+
+// NOTE(dan): work queues are served by a pool with a worker per core. high priority
+// work always goes first, complete_all_work helps out until the queue is empty
+struct PlatformWorkQueue;
+
+#define PLATFORM_WORK_QUEUE_CALLBACK(name)  void name(PlatformWorkQueue *queue, void *data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(PlatformWorkQueueCallback);
+
+#define PLATFORM_ADD_WORK(name)             void name(PlatformWorkQueue *queue, PlatformWorkQueueCallback *callback, void *data)
+#define PLATFORM_COMPLETE_ALL_WORK(name)    void name(PlatformWorkQueue *queue)
+#define PLATFORM_COMPLETE_WORK_BEFORE(name) b32 name(PlatformWorkQueue *queue, f64 deadline)
+
+#define PLATFORM_SHOW_NOTIFICATIONS(name)   void name(Notification *notifications, u32 count)
+#define PLATFORM_SIGNAL_EVENTS(name)        void name()
 #define PLATFORM_UNLOAD_FILE(name)          void name(LoadedFile file)
 #define PLATFORM_LOAD_FILE(name)            LoadedFile name(char *filename)
+#define PLATFORM_WRITE_ENTIRE_FILE(name)    b32 name(char *filename, void *memory, u32 size)
 #define PLATFORM_CACHE_LOGO(name)           void name(char *url, u32 logo_hash)
+#define PLATFORM_MAP_FILE(name)             b32 name(char *filename, u64 size, b32 create, PlatformMappedFile *file)
+#define PLATFORM_UNMAP_FILE(name)           void name(PlatformMappedFile *file)
+#define PLATFORM_FLUSH_MAPPED_FILE(name)    void name(PlatformMappedFile *file, u64 offset, u64 size)
+#define PLATFORM_DELETE_FILE(name)          void name(char *filename)
 
-typedef PLATFORM_SHOW_NOTIFICATION(PlatformShowNotification);
+typedef PLATFORM_ADD_WORK(PlatformAddWork);
+typedef PLATFORM_COMPLETE_ALL_WORK(PlatformCompleteAllWork);
+typedef PLATFORM_COMPLETE_WORK_BEFORE(PlatformCompleteWorkBefore);
+typedef PLATFORM_SHOW_NOTIFICATIONS(PlatformShowNotifications);
+typedef PLATFORM_SIGNAL_EVENTS(PlatformSignalEvents);
 typedef PLATFORM_UNLOAD_FILE(PlatformUnloadFile);
 typedef PLATFORM_LOAD_FILE(PlatformLoadFile);
+typedef PLATFORM_WRITE_ENTIRE_FILE(PlatformWriteEntireFile);
 typedef PLATFORM_CACHE_LOGO(PlatformCacheLogo);
+typedef PLATFORM_MAP_FILE(PlatformMapFile);
+typedef PLATFORM_UNMAP_FILE(PlatformUnmapFile);
+typedef PLATFORM_FLUSH_MAPPED_FILE(PlatformFlushMappedFile);
+typedef PLATFORM_DELETE_FILE(PlatformDeleteFile);
 
 struct Platform
 {
-    PlatformShowNotification *show_notification;
+    PlatformWorkQueue *high_priority_queue;
+    PlatformWorkQueue *low_priority_queue;
+    PlatformAddWork *add_work;
+    PlatformCompleteAllWork *complete_all_work;
+    PlatformCompleteWorkBefore *complete_work_before;   // NOTE(dan): deadline on the platform's monotonic clock, returns whether it's all done
+
+    PlatformShowNotifications *show_notifications;
+    PlatformSignalEvents *signal_events;
     PlatformLoadFile *load_file;
     PlatformUnloadFile *unload_file;
+    PlatformWriteEntireFile *write_entire_file;
     PlatformCacheLogo *cache_logo;
+
+    PlatformMapFile *map_file;                          // NOTE(dan): grows the file to the size, creates it only when asked
+    PlatformUnmapFile *unmap_file;
+    PlatformFlushMappedFile *flush_mapped_file;         // NOTE(dan): returns once the range is on disk
+    PlatformDeleteFile *delete_file;
 };
 
 extern Platform platform;
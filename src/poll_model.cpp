@@ -0,0 +1,76 @@
+// NOTE(dan): wall_seconds can count from any fixed epoch, only the position in the week matters
+inline u32 get_poll_model_bucket(u64 wall_seconds)
+{
+    u32 bucket = (u32)((wall_seconds % POLL_MODEL_WEEK_SECS) / POLL_MODEL_BUCKET_SECS);
+    return bucket;
+}
+
+static void record_go_live(PollModel *model, u64 wall_seconds)
+{
+    if (model->num_go_lives >= POLL_MODEL_MAX_GO_LIVES)
+    {
+        model->num_go_lives = 0;
+        for (u32 bucket = 0; bucket < POLL_MODEL_BUCKETS; ++bucket)
+        {
+            model->go_lives[bucket] /= 2;
+            model->num_go_lives += model->go_lives[bucket];
+        }
+    }
+
+    ++model->go_lives[get_poll_model_bucket(wall_seconds)];
+    ++model->num_go_lives;
+}
+
+// NOTE(dan): how many times likelier than average a go-live is in the bucket,
+// smoothed with its neighbours because nobody starts at exactly the same time
+static f32 get_go_live_likelihood(PollModel *model, u32 bucket)
+{
+    u32 prev_bucket = (bucket + POLL_MODEL_BUCKETS - 1) % POLL_MODEL_BUCKETS;
+    u32 next_bucket = (bucket + 1) % POLL_MODEL_BUCKETS;
+
+    f32 smoothed = (model->go_lives[prev_bucket] + 2*model->go_lives[bucket] + model->go_lives[next_bucket]) / 4.0f;
+    f32 average = (f32)model->num_go_lives / (f32)POLL_MODEL_BUCKETS;
+
+    f32 likelihood = smoothed / average;
+    return likelihood;
+}
+
+// NOTE(dan): the longest interval under which every bucket it spans is unlikely enough
+static u32 get_adaptive_poll_interval(PollModel *model, u64 wall_seconds, u32 base_interval)
+{
+    u32 interval = base_interval;
+    if (model->num_go_lives >= POLL_MODEL_MIN_GO_LIVES)
+    {
+        u32 intervals[] = { base_interval*8, base_interval*4, base_interval*2, base_interval };
+        f32 max_likelihoods[] = { 0.1f, 0.25f, 1.0f };
+
+        interval = intervals[array_count(intervals) - 1];
+        for (u32 level = 0; level < array_count(max_likelihoods); ++level)
+        {
+            u32 first_bucket = get_poll_model_bucket(wall_seconds);
+            u32 num_buckets = (u32)((wall_seconds % POLL_MODEL_BUCKET_SECS) + intervals[level]) / POLL_MODEL_BUCKET_SECS + 1;
+
+            f32 likelihood = 0.0f;
+            for (u32 bucket_index = 0; bucket_index < num_buckets; ++bucket_index)
+            {
+                f32 bucket_likelihood = get_go_live_likelihood(model, (first_bucket + bucket_index) % POLL_MODEL_BUCKETS);
+                if (likelihood < bucket_likelihood)
+                {
+                    likelihood = bucket_likelihood;
+                }
+            }
+
+            if (likelihood < max_likelihoods[level])
+            {
+                interval = intervals[level];
+                break;
+            }
+        }
+    }
+
+    if (!interval)
+    {
+        interval = 1;
+    }
+    return interval;
+}
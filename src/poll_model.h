@@ -0,0 +1,33 @@
+// NOTE(dan): a weekly histogram of when a channel went live. polls stay on the base
+// interval around the times the channel usually starts and get further apart when
+// it has never started around this time. they never get closer than the base
+// interval: every channel shares the streams request, so one channel polled faster
+// makes the request for all of them go out faster. the intervals are power of two
+// multiples of the base interval, so the deadlines of different channels keep
+// landing on the same ticks and still share requests
+#define POLL_MODEL_FILE_MAGIC       0x4D505757 // NOTE(dan): "WWPM"
+#define POLL_MODEL_FILE_VERSION     2 // NOTE(dan): 2 counts the week from the unix epoch
+#define POLL_MODEL_WEEK_SECS        (7 * 24 * 60 * 60)
+#define POLL_MODEL_BUCKET_SECS      (15 * 60)
+#define POLL_MODEL_BUCKETS          (POLL_MODEL_WEEK_SECS / POLL_MODEL_BUCKET_SECS)
+#define POLL_MODEL_MIN_GO_LIVES     5   // NOTE(dan): below that the base interval is used
+#define POLL_MODEL_MAX_GO_LIVES     200 // NOTE(dan): then old go-lives count half, schedules change
+
+struct PollModel
+{
+    u32 num_go_lives;
+    u16 go_lives[POLL_MODEL_BUCKETS];
+};
+
+struct PollModelFileHeader
+{
+    u32 magic;
+    u32 version;
+    u32 num_entries;
+};
+
+struct PollModelFileEntry
+{
+    u32 name_hash;
+    PollModel model;
+};
@@ -0,0 +1,210 @@
+static void init_poll_scheduler(PollScheduler *scheduler, PollTimer *timers, u32 num_timers, u64 now)
+{
+    scheduler->now = now;
+    scheduler->num_timers = num_timers;
+    scheduler->timers = timers;
+
+    scheduler->due_head = POLL_TIMER_NONE;
+    scheduler->due_tail = POLL_TIMER_NONE;
+    scheduler->num_due = 0;
+
+    for (u32 level = 0; level < POLL_WHEEL_LEVELS; ++level)
+    {
+        scheduler->occupied[level] = 0;
+        for (u32 slot = 0; slot < POLL_WHEEL_SLOTS; ++slot)
+        {
+            scheduler->slots[level][slot] = POLL_TIMER_NONE;
+        }
+    }
+
+    for (u32 timer_index = 0; timer_index < num_timers; ++timer_index)
+    {
+        PollTimer *timer = timers + timer_index;
+        timer->deadline = 0;
+        timer->next = POLL_TIMER_NONE;
+        timer->prev = POLL_TIMER_NONE;
+        timer->list = POLL_TIMER_NONE;
+    }
+}
+
+static void unschedule_poll(PollScheduler *scheduler, u32 timer_index)
+{
+    PollTimer *timer = scheduler->timers + timer_index;
+    if (timer->list == POLL_TIMER_DUE)
+    {
+        if (timer->prev != POLL_TIMER_NONE)
+        {
+            scheduler->timers[timer->prev].next = timer->next;
+        }
+        else
+        {
+            scheduler->due_head = timer->next;
+        }
+
+        if (timer->next != POLL_TIMER_NONE)
+        {
+            scheduler->timers[timer->next].prev = timer->prev;
+        }
+        else
+        {
+            scheduler->due_tail = timer->prev;
+        }
+        --scheduler->num_due;
+    }
+    else if (timer->list != POLL_TIMER_NONE)
+    {
+        u32 level = timer->list / POLL_WHEEL_SLOTS;
+        u32 slot = timer->list % POLL_WHEEL_SLOTS;
+
+        if (timer->prev != POLL_TIMER_NONE)
+        {
+            scheduler->timers[timer->prev].next = timer->next;
+        }
+        else
+        {
+            scheduler->slots[level][slot] = timer->next;
+            if (timer->next == POLL_TIMER_NONE)
+            {
+                scheduler->occupied[level] &= ~((u64)1 << slot);
+            }
+        }
+
+        if (timer->next != POLL_TIMER_NONE)
+        {
+            scheduler->timers[timer->next].prev = timer->prev;
+        }
+    }
+
+    timer->next = POLL_TIMER_NONE;
+    timer->prev = POLL_TIMER_NONE;
+    timer->list = POLL_TIMER_NONE;
+}
+
+// NOTE(dan): due channels are served in the order they became due
+static void append_due_poll(PollScheduler *scheduler, u32 timer_index)
+{
+    PollTimer *timer = scheduler->timers + timer_index;
+    timer->list = POLL_TIMER_DUE;
+    timer->next = POLL_TIMER_NONE;
+    timer->prev = scheduler->due_tail;
+
+    if (scheduler->due_tail != POLL_TIMER_NONE)
+    {
+        scheduler->timers[scheduler->due_tail].next = timer_index;
+    }
+    else
+    {
+        scheduler->due_head = timer_index;
+    }
+    scheduler->due_tail = timer_index;
+    ++scheduler->num_due;
+}
+
+// NOTE(dan): a timer goes to the lowest level whose slot range still tells its
+// deadline apart from now, it moves down a level every time that slot comes up
+static void insert_poll_timer(PollScheduler *scheduler, u32 timer_index)
+{
+    PollTimer *timer = scheduler->timers + timer_index;
+    if (timer->deadline <= scheduler->now)
+    {
+        append_due_poll(scheduler, timer_index);
+    }
+    else
+    {
+        u32 level = 0;
+        while ((level + 1) < POLL_WHEEL_LEVELS &&
+               (timer->deadline >> ((level + 1)*POLL_WHEEL_SLOT_BITS)) != (scheduler->now >> ((level + 1)*POLL_WHEEL_SLOT_BITS)))
+        {
+            ++level;
+        }
+        u32 slot = (u32)(timer->deadline >> (level*POLL_WHEEL_SLOT_BITS)) & (POLL_WHEEL_SLOTS - 1);
+
+        timer->list = level*POLL_WHEEL_SLOTS + slot;
+        timer->prev = POLL_TIMER_NONE;
+        timer->next = scheduler->slots[level][slot];
+        if (timer->next != POLL_TIMER_NONE)
+        {
+            scheduler->timers[timer->next].prev = timer_index;
+        }
+        scheduler->slots[level][slot] = timer_index;
+        scheduler->occupied[level] |= ((u64)1 << slot);
+    }
+}
+
+static void schedule_poll(PollScheduler *scheduler, u32 timer_index, u64 deadline)
+{
+    assert(timer_index < scheduler->num_timers);
+
+    unschedule_poll(scheduler, timer_index);
+
+    // NOTE(dan): the wheel only reaches so far ahead, later deadlines wait at its edge
+    u64 max_deadline = scheduler->now + POLL_WHEEL_MAX_DELAY;
+    scheduler->timers[timer_index].deadline = (deadline < max_deadline) ? deadline : max_deadline;
+
+    insert_poll_timer(scheduler, timer_index);
+}
+
+// NOTE(dan): takes a whole slot off the wheel and puts its timers back in, they land
+// on a lower level or in the due list
+static void cascade_poll_slot(PollScheduler *scheduler, u32 level, u32 slot)
+{
+    u32 timer_index = scheduler->slots[level][slot];
+    scheduler->slots[level][slot] = POLL_TIMER_NONE;
+    scheduler->occupied[level] &= ~((u64)1 << slot);
+
+    while (timer_index != POLL_TIMER_NONE)
+    {
+        u32 next = scheduler->timers[timer_index].next;
+        insert_poll_timer(scheduler, timer_index);
+        timer_index = next;
+    }
+}
+
+static void advance_poll_scheduler(PollScheduler *scheduler, u64 now)
+{
+    while (scheduler->now < now)
+    {
+        b32 wheel_empty = true;
+        for (u32 level = 0; level < POLL_WHEEL_LEVELS; ++level)
+        {
+            if (scheduler->occupied[level])
+            {
+                wheel_empty = false;
+                break;
+            }
+        }
+
+        if (wheel_empty)
+        {
+            // NOTE(dan): nothing to expire on the way, e.g. after the machine slept
+            scheduler->now = now;
+            break;
+        }
+
+        ++scheduler->now;
+        for (u32 level = 1; level < POLL_WHEEL_LEVELS; ++level)
+        {
+            u64 lower_ticks = scheduler->now & (((u64)1 << (level*POLL_WHEEL_SLOT_BITS)) - 1);
+            if (lower_ticks)
+            {
+                break;
+            }
+            u32 slot = (u32)(scheduler->now >> (level*POLL_WHEEL_SLOT_BITS)) & (POLL_WHEEL_SLOTS - 1);
+            cascade_poll_slot(scheduler, level, slot);
+        }
+        cascade_poll_slot(scheduler, 0, (u32)scheduler->now & (POLL_WHEEL_SLOTS - 1));
+    }
+}
+
+// NOTE(dan): takes up to max_count due channels off the due list, returns how many
+static u32 take_due_polls(PollScheduler *scheduler, u32 *timer_indices, u32 max_count)
+{
+    u32 count = 0;
+    while (count < max_count && scheduler->due_head != POLL_TIMER_NONE)
+    {
+        u32 timer_index = scheduler->due_head;
+        unschedule_poll(scheduler, timer_index);
+        timer_indices[count++] = timer_index;
+    }
+    return count;
+}
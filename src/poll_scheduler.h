@@ -0,0 +1,37 @@
+// NOTE(dan): every channel has its own next poll deadline. deadlines live in a
+// hierarchical timing wheel, four levels of 64 slots with one second ticks, so
+// scheduling, unscheduling and expiring a channel is O(1) no matter how many
+// channels there are. due channels queue up until they are taken in batches
+#define POLL_WHEEL_LEVELS       4
+#define POLL_WHEEL_SLOT_BITS    6
+#define POLL_WHEEL_SLOTS        (1 << POLL_WHEEL_SLOT_BITS)
+#define POLL_WHEEL_MAX_DELAY    (((u64)1 << (POLL_WHEEL_LEVELS*POLL_WHEEL_SLOT_BITS)) - 1)
+
+#define POLL_TIMER_NONE         0xFFFFFFFF
+#define POLL_TIMER_DUE          0xFFFFFFFE
+
+struct PollTimer
+{
+    u64 deadline;
+
+    u32 next;
+    u32 prev;
+
+    // NOTE(dan): level*POLL_WHEEL_SLOTS + slot, POLL_TIMER_DUE or POLL_TIMER_NONE
+    u32 list;
+};
+
+struct PollScheduler
+{
+    u64 now;
+
+    u32 num_timers;
+    PollTimer *timers;
+
+    u32 due_head;
+    u32 due_tail;
+    u32 num_due;
+
+    u64 occupied[POLL_WHEEL_LEVELS];
+    u32 slots[POLL_WHEEL_LEVELS][POLL_WHEEL_SLOTS];
+};
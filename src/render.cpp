@@ -0,0 +1,557 @@
+inline u32 *get_pixel_pointer(Bitmap *bitmap, i32 x, i32 y)
+{
+    u32 *pixel = (u32 *)(bitmap->memory + y * bitmap->pitch) + x;
+    return pixel;
+}
+
+inline u32 blend_premultiplied(u32 src, u32 dest)
+{
+    u32 inv_alpha = 255 - (src >> 24);
+
+    u32 dest_rb = (dest & 0x00FF00FF) * inv_alpha + 0x00800080;
+    u32 dest_ag = ((dest >> 8) & 0x00FF00FF) * inv_alpha + 0x00800080;
+    dest_rb = ((dest_rb + ((dest_rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    dest_ag = (dest_ag + ((dest_ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+
+    u32 result = src + (dest_rb | dest_ag);
+    return result;
+}
+
+inline u32 scale_premultiplied(u32 color, u32 alpha)
+{
+    u32 rb = (color & 0x00FF00FF) * alpha + 0x00800080;
+    u32 ag = ((color >> 8) & 0x00FF00FF) * alpha + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+
+    u32 result = rb | ag;
+    return result;
+}
+
+//
+// NOTE(dan): scalar kernels
+//
+
+static FILL_ROW(fill_row_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        *dest++ = color;
+    }
+}
+
+static BLEND_ROW(blend_row_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        *dest = blend_premultiplied(*src++, *dest);
+        ++dest;
+    }
+}
+
+static BLEND_ROW_CONSTANT_ALPHA(blend_row_constant_alpha_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        *dest = blend_premultiplied(scale_premultiplied(*src++, alpha), *dest);
+        ++dest;
+    }
+}
+
+static BLEND_COVERAGE_ROW(blend_coverage_row_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        u32 alpha = *coverage++;
+        if (alpha)
+        {
+            *dest = blend_premultiplied(scale_premultiplied(color, alpha), *dest);
+        }
+        ++dest;
+    }
+}
+
+static CONVERT_ROW(convert_gray_row_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        u32 gray = *src++;
+        *dest++ = 0xFF000000 | (gray << 16) | (gray << 8) | gray;
+    }
+}
+
+static CONVERT_ROW(convert_gray_alpha_row_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        u32 a = src[1];
+        u32 gray = (src[0] * a + 127) / 255;
+
+        *dest++ = (a << 24) | (gray << 16) | (gray << 8) | gray;
+        src += 2;
+    }
+}
+
+static CONVERT_ROW(convert_rgb_row_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        u32 r = src[0];
+        u32 g = src[1];
+        u32 b = src[2];
+
+        *dest++ = 0xFF000000 | (r << 16) | (g << 8) | b;
+        src += 3;
+    }
+}
+
+static CONVERT_ROW(convert_rgba_row_scalar)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        u32 r = src[0];
+        u32 g = src[1];
+        u32 b = src[2];
+        u32 a = src[3];
+
+        r = (r * a + 127) / 255;
+        g = (g * a + 127) / 255;
+        b = (b * a + 127) / 255;
+
+        *dest++ = (a << 24) | (r << 16) | (g << 8) | b;
+        src += 4;
+    }
+}
+
+//
+// NOTE(dan): sse2 kernels, 4 pixels at a time. channels are widened to 16 bits
+// and divided by 255 with the same rounding as the scalar code
+//
+
+inline __m128i mul_div_255_sse2(__m128i value, __m128i factor)
+{
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(value, factor), _mm_set1_epi16(0x80));
+    __m128i result = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    return result;
+}
+
+inline __m128i broadcast_alpha_sse2(__m128i pixels16)
+{
+    __m128i result = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    return result;
+}
+
+inline __m128i blend_premultiplied_sse2(__m128i src, __m128i dest)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i max = _mm_set1_epi16(255);
+
+    __m128i inv_alpha_lo = _mm_sub_epi16(max, broadcast_alpha_sse2(_mm_unpacklo_epi8(src, zero)));
+    __m128i inv_alpha_hi = _mm_sub_epi16(max, broadcast_alpha_sse2(_mm_unpackhi_epi8(src, zero)));
+
+    __m128i dest_lo = mul_div_255_sse2(_mm_unpacklo_epi8(dest, zero), inv_alpha_lo);
+    __m128i dest_hi = mul_div_255_sse2(_mm_unpackhi_epi8(dest, zero), inv_alpha_hi);
+
+    __m128i result = _mm_add_epi8(src, _mm_packus_epi16(dest_lo, dest_hi));
+    return result;
+}
+
+inline __m128i scale_premultiplied_sse2(__m128i src, __m128i alpha16)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i src_lo = mul_div_255_sse2(_mm_unpacklo_epi8(src, zero), alpha16);
+    __m128i src_hi = mul_div_255_sse2(_mm_unpackhi_epi8(src, zero), alpha16);
+
+    __m128i result = _mm_packus_epi16(src_lo, src_hi);
+    return result;
+}
+
+static FILL_ROW(fill_row_sse2)
+{
+    __m128i color4 = _mm_set1_epi32((int)color);
+    for (; count >= 4; count -= 4)
+    {
+        _mm_storeu_si128((__m128i *)dest, color4);
+        dest += 4;
+    }
+    fill_row_scalar(dest, color, count);
+}
+
+static BLEND_ROW(blend_row_sse2)
+{
+    __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+    for (; count >= 4; count -= 4)
+    {
+        __m128i src4 = _mm_loadu_si128((__m128i *)src);
+        __m128i alpha = _mm_and_si128(src4, alpha_mask);
+
+        // NOTE(dan): logos are mostly opaque or fully transparent
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFF)
+        {
+            _mm_storeu_si128((__m128i *)dest, src4);
+        }
+        else if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_setzero_si128())) != 0xFFFF)
+        {
+            __m128i dest4 = _mm_loadu_si128((__m128i *)dest);
+            _mm_storeu_si128((__m128i *)dest, blend_premultiplied_sse2(src4, dest4));
+        }
+
+        src += 4;
+        dest += 4;
+    }
+    blend_row_scalar(dest, src, count);
+}
+
+static BLEND_ROW_CONSTANT_ALPHA(blend_row_constant_alpha_sse2)
+{
+    __m128i alpha16 = _mm_set1_epi16((short)alpha);
+    for (; count >= 4; count -= 4)
+    {
+        __m128i src4 = scale_premultiplied_sse2(_mm_loadu_si128((__m128i *)src), alpha16);
+        __m128i dest4 = _mm_loadu_si128((__m128i *)dest);
+        _mm_storeu_si128((__m128i *)dest, blend_premultiplied_sse2(src4, dest4));
+
+        src += 4;
+        dest += 4;
+    }
+    blend_row_constant_alpha_scalar(dest, src, count, alpha);
+}
+
+static BLEND_COVERAGE_ROW(blend_coverage_row_sse2)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i color16 = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    for (; count >= 4; count -= 4)
+    {
+        int coverage4 = *(int *)coverage;
+        if (coverage4)
+        {
+            // NOTE(dan): every coverage byte spread over the four channels of its pixel
+            __m128i coverage16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(coverage4), zero);
+            coverage16 = _mm_unpacklo_epi16(coverage16, coverage16);
+            __m128i coverage_lo = _mm_unpacklo_epi32(coverage16, coverage16);
+            __m128i coverage_hi = _mm_unpackhi_epi32(coverage16, coverage16);
+
+            __m128i src4 = _mm_packus_epi16(mul_div_255_sse2(color16, coverage_lo), mul_div_255_sse2(color16, coverage_hi));
+            __m128i dest4 = _mm_loadu_si128((__m128i *)dest);
+            _mm_storeu_si128((__m128i *)dest, blend_premultiplied_sse2(src4, dest4));
+        }
+
+        coverage += 4;
+        dest += 4;
+    }
+    blend_coverage_row_scalar(dest, coverage, count, color);
+}
+
+//
+// NOTE(dan): ssse3 conversion kernels, the channel swizzle is a single pshufb.
+// (x * a + 127) / 255 and the rounding of mul_div_255 agree for every x and a
+//
+
+TARGET_SSSE3 static CONVERT_ROW(convert_gray_row_ssse3)
+{
+    __m128i broadcast = _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1);
+    __m128i opaque = _mm_set1_epi32(0xFF000000);
+    for (; count >= 4; count -= 4)
+    {
+        __m128i gray = _mm_cvtsi32_si128(*(int *)src);
+        _mm_storeu_si128((__m128i *)dest, _mm_or_si128(_mm_shuffle_epi8(gray, broadcast), opaque));
+
+        src += 4;
+        dest += 4;
+    }
+    convert_gray_row_scalar(dest, src, count);
+}
+
+TARGET_SSSE3 static CONVERT_ROW(convert_rgb_row_ssse3)
+{
+    __m128i swizzle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    __m128i opaque = _mm_set1_epi32(0xFF000000);
+
+    // NOTE(dan): 4 pixels are 12 bytes but the load is 16, stay clear of the end
+    for (; count >= 6; count -= 4)
+    {
+        __m128i rgb = _mm_loadu_si128((__m128i *)src);
+        _mm_storeu_si128((__m128i *)dest, _mm_or_si128(_mm_shuffle_epi8(rgb, swizzle), opaque));
+
+        src += 12;
+        dest += 4;
+    }
+    convert_rgb_row_scalar(dest, src, count);
+}
+
+TARGET_SSSE3 static CONVERT_ROW(convert_rgba_row_ssse3)
+{
+    __m128i swizzle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+    __m128i zero = _mm_setzero_si128();
+    for (; count >= 4; count -= 4)
+    {
+        __m128i bgra = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)src), swizzle);
+
+        __m128i lo = _mm_unpacklo_epi8(bgra, zero);
+        __m128i hi = _mm_unpackhi_epi8(bgra, zero);
+        lo = mul_div_255_sse2(lo, broadcast_alpha_sse2(lo));
+        hi = mul_div_255_sse2(hi, broadcast_alpha_sse2(hi));
+
+        // NOTE(dan): alpha itself stays as it was
+        __m128i premultiplied = _mm_andnot_si128(alpha_mask, _mm_packus_epi16(lo, hi));
+        _mm_storeu_si128((__m128i *)dest, _mm_or_si128(premultiplied, _mm_and_si128(bgra, alpha_mask)));
+
+        src += 16;
+        dest += 4;
+    }
+    convert_rgba_row_scalar(dest, src, count);
+}
+
+//
+// NOTE(dan): avx2 kernels, 8 pixels at a time. unpack and pack work within
+// 128-bit lanes, so the pixel order comes out unchanged
+//
+
+TARGET_AVX2 inline __m256i mul_div_255_avx2(__m256i value, __m256i factor)
+{
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(value, factor), _mm256_set1_epi16(0x80));
+    __m256i result = _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    return result;
+}
+
+TARGET_AVX2 inline __m256i broadcast_alpha_avx2(__m256i pixels16)
+{
+    __m256i result = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    return result;
+}
+
+TARGET_AVX2 inline __m256i blend_premultiplied_avx2(__m256i src, __m256i dest)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i max = _mm256_set1_epi16(255);
+
+    __m256i inv_alpha_lo = _mm256_sub_epi16(max, broadcast_alpha_avx2(_mm256_unpacklo_epi8(src, zero)));
+    __m256i inv_alpha_hi = _mm256_sub_epi16(max, broadcast_alpha_avx2(_mm256_unpackhi_epi8(src, zero)));
+
+    __m256i dest_lo = mul_div_255_avx2(_mm256_unpacklo_epi8(dest, zero), inv_alpha_lo);
+    __m256i dest_hi = mul_div_255_avx2(_mm256_unpackhi_epi8(dest, zero), inv_alpha_hi);
+
+    __m256i result = _mm256_add_epi8(src, _mm256_packus_epi16(dest_lo, dest_hi));
+    return result;
+}
+
+TARGET_AVX2 inline __m256i scale_premultiplied_avx2(__m256i src, __m256i alpha16)
+{
+    __m256i zero = _mm256_setzero_si256();
+    __m256i src_lo = mul_div_255_avx2(_mm256_unpacklo_epi8(src, zero), alpha16);
+    __m256i src_hi = mul_div_255_avx2(_mm256_unpackhi_epi8(src, zero), alpha16);
+
+    __m256i result = _mm256_packus_epi16(src_lo, src_hi);
+    return result;
+}
+
+TARGET_AVX2 static FILL_ROW(fill_row_avx2)
+{
+    __m256i color8 = _mm256_set1_epi32((int)color);
+    for (; count >= 8; count -= 8)
+    {
+        _mm256_storeu_si256((__m256i *)dest, color8);
+        dest += 8;
+    }
+    fill_row_sse2(dest, color, count);
+}
+
+TARGET_AVX2 static BLEND_ROW(blend_row_avx2)
+{
+    __m256i alpha_mask = _mm256_set1_epi32(0xFF000000);
+    for (; count >= 8; count -= 8)
+    {
+        __m256i src8 = _mm256_loadu_si256((__m256i *)src);
+        __m256i alpha = _mm256_and_si256(src8, alpha_mask);
+
+        // NOTE(dan): logos are mostly opaque or fully transparent
+        if ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alpha_mask)) == 0xFFFFFFFF)
+        {
+            _mm256_storeu_si256((__m256i *)dest, src8);
+        }
+        else if ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_setzero_si256())) != 0xFFFFFFFF)
+        {
+            __m256i dest8 = _mm256_loadu_si256((__m256i *)dest);
+            _mm256_storeu_si256((__m256i *)dest, blend_premultiplied_avx2(src8, dest8));
+        }
+
+        src += 8;
+        dest += 8;
+    }
+    blend_row_sse2(dest, src, count);
+}
+
+TARGET_AVX2 static BLEND_ROW_CONSTANT_ALPHA(blend_row_constant_alpha_avx2)
+{
+    __m256i alpha16 = _mm256_set1_epi16((short)alpha);
+    for (; count >= 8; count -= 8)
+    {
+        __m256i src8 = scale_premultiplied_avx2(_mm256_loadu_si256((__m256i *)src), alpha16);
+        __m256i dest8 = _mm256_loadu_si256((__m256i *)dest);
+        _mm256_storeu_si256((__m256i *)dest, blend_premultiplied_avx2(src8, dest8));
+
+        src += 8;
+        dest += 8;
+    }
+    blend_row_constant_alpha_sse2(dest, src, count, alpha);
+}
+
+static RenderKernels render_kernels =
+{
+    fill_row_sse2,
+    blend_row_sse2,
+    blend_row_constant_alpha_sse2,
+    blend_coverage_row_sse2,
+    {
+        0,
+        convert_gray_row_scalar,
+        convert_gray_alpha_row_scalar,
+        convert_rgb_row_scalar,
+        convert_rgba_row_scalar,
+    },
+};
+
+static void init_render_kernels()
+{
+    if (cpu_supports_ssse3())
+    {
+        render_kernels.convert_row[1] = convert_gray_row_ssse3;
+        render_kernels.convert_row[3] = convert_rgb_row_ssse3;
+        render_kernels.convert_row[4] = convert_rgba_row_ssse3;
+    }
+
+    if (cpu_supports_avx2())
+    {
+        render_kernels.fill_row = fill_row_avx2;
+        render_kernels.blend_row = blend_row_avx2;
+        render_kernels.blend_row_constant_alpha = blend_row_constant_alpha_avx2;
+    }
+}
+
+static void convert_to_premultiplied_bgra(u32 *dest, u8 *src, u32 channels, u32 pixel_count)
+{
+    assert((channels >= 1) && (channels <= 4));
+    render_kernels.convert_row[channels](dest, src, (i32)pixel_count);
+}
+
+inline void set_pixel(Bitmap *bitmap, i32 x, i32 y, u32 color)
+{
+    if ((x >= 0) && (y >= 0) && (x < bitmap->width) && (y < bitmap->height))
+    {
+        *get_pixel_pointer(bitmap, x, y) = color;
+    }
+}
+
+// NOTE(dan): min is inclusive, max is exclusive
+static void draw_rectangle(Bitmap *bitmap, i32 min_x, i32 min_y, i32 max_x, i32 max_y, u32 color)
+{
+    if (min_x < 0) min_x = 0;
+    if (min_y < 0) min_y = 0;
+    if (max_x > bitmap->width) max_x = bitmap->width;
+    if (max_y > bitmap->height) max_y = bitmap->height;
+
+    if (min_x < max_x)
+    {
+        for (i32 y = min_y; y < max_y; ++y)
+        {
+            render_kernels.fill_row(get_pixel_pointer(bitmap, min_x, y), color, max_x - min_x);
+        }
+    }
+}
+
+static void round_corners(Bitmap *bitmap, i32 min_x, i32 min_y, i32 width, i32 height, u32 fade_color, u32 corner_color)
+{
+    i32 max_x = min_x + width - 1;
+    i32 max_y = min_y + height - 1;
+
+    // NOTE(dan): top-left corner
+    set_pixel(bitmap, min_x + 0, min_y + 0, fade_color);
+    set_pixel(bitmap, min_x + 1, min_y + 0, corner_color);
+    set_pixel(bitmap, min_x + 0, min_y + 1, corner_color);
+
+    // NOTE(dan): top-right corner
+    set_pixel(bitmap, max_x - 0, min_y + 0, fade_color);
+    set_pixel(bitmap, max_x - 1, min_y + 0, corner_color);
+    set_pixel(bitmap, max_x - 0, min_y + 1, corner_color);
+
+    // NOTE(dan): bottom-left corner
+    set_pixel(bitmap, min_x + 0, max_y - 0, fade_color);
+    set_pixel(bitmap, min_x + 1, max_y - 0, corner_color);
+    set_pixel(bitmap, min_x + 0, max_y - 1, corner_color);
+
+    // NOTE(dan): bottom-right corner
+    set_pixel(bitmap, max_x - 0, max_y - 0, fade_color);
+    set_pixel(bitmap, max_x - 1, max_y - 0, corner_color);
+    set_pixel(bitmap, max_x - 0, max_y - 1, corner_color);
+}
+
+// NOTE(dan): premultiplied source-over with a constant alpha on top, the source
+// is clipped to the destination
+static void draw_bitmap(Bitmap *dest, Bitmap *src, i32 x, i32 y, u32 alpha)
+{
+    i32 src_x = 0;
+    i32 src_y = 0;
+    i32 width = src->width;
+    i32 height = src->height;
+
+    if (x < 0)
+    {
+        src_x = -x;
+        width += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        src_y = -y;
+        height += y;
+        y = 0;
+    }
+    if (width > dest->width - x)
+    {
+        width = dest->width - x;
+    }
+    if (height > dest->height - y)
+    {
+        height = dest->height - y;
+    }
+
+    if ((width > 0) && (alpha > 0))
+    {
+        for (i32 row = 0; row < height; ++row)
+        {
+            u32 *src_pixel = get_pixel_pointer(src, src_x, src_y + row);
+            u32 *dest_pixel = get_pixel_pointer(dest, x, y + row);
+
+            if (alpha >= 255)
+            {
+                render_kernels.blend_row(dest_pixel, src_pixel, width);
+            }
+            else
+            {
+                render_kernels.blend_row_constant_alpha(dest_pixel, src_pixel, width, alpha);
+            }
+        }
+    }
+}
+
+// NOTE(dan): one memory copy when both bitmaps are laid out the same way
+static void copy_bitmap(Bitmap *dest, Bitmap *src)
+{
+    assert((dest->width == src->width) && (dest->height == src->height));
+
+    i32 row_size = dest->width * 4;
+    if ((dest->pitch == src->pitch) && ((dest->pitch == row_size) || (dest->pitch == -row_size)))
+    {
+        i32 lowest_row = (dest->pitch < 0) ? (dest->height - 1) : 0;
+        copy_memory(dest->memory + lowest_row * dest->pitch, src->memory + lowest_row * src->pitch, (usize)row_size * dest->height);
+    }
+    else
+    {
+        for (i32 y = 0; y < dest->height; ++y)
+        {
+            copy_memory(dest->memory + y * dest->pitch, src->memory + y * src->pitch, row_size);
+        }
+    }
+}
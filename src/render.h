@@ -0,0 +1,38 @@
+// NOTE(dan): cards are drawn in software into a caller-provided BGRA buffer,
+// the platform layer only presents the result. all colors are premultiplied
+
+struct Bitmap
+{
+    i32 width;
+    i32 height;
+    i32 pitch;      // NOTE(dan): in bytes, negative for bottom-up buffers
+    u8 *memory;     // NOTE(dan): points at the top-left pixel
+};
+
+// NOTE(dan): row kernels, picked once at startup for the best instruction set
+// the cpu supports. every kernel gives the same result as the scalar version
+#define FILL_ROW(name)                      void name(u32 *dest, u32 color, i32 count)
+#define BLEND_ROW(name)                     void name(u32 *dest, u32 *src, i32 count)
+#define BLEND_ROW_CONSTANT_ALPHA(name)      void name(u32 *dest, u32 *src, i32 count, u32 alpha)
+
+#define BLEND_COVERAGE_ROW(name)            void name(u32 *dest, u8 *coverage, i32 count, u32 color)
+#define CONVERT_ROW(name)                   void name(u32 *dest, u8 *src, i32 count)
+
+typedef FILL_ROW(FillRow);
+typedef BLEND_ROW(BlendRow);
+typedef BLEND_ROW_CONSTANT_ALPHA(BlendRowConstantAlpha);
+typedef BLEND_COVERAGE_ROW(BlendCoverageRow);
+typedef CONVERT_ROW(ConvertRow);
+
+struct RenderKernels
+{
+    FillRow *fill_row;
+    BlendRow *blend_row;
+    BlendRowConstantAlpha *blend_row_constant_alpha;
+
+    // NOTE(dan): a solid color through 8-bit coverage, for glyphs
+    BlendCoverageRow *blend_coverage_row;
+
+    // NOTE(dan): decoded images to premultiplied BGRA, indexed by channel count
+    ConvertRow *convert_row[5];
+};
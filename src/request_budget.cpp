@@ -0,0 +1,119 @@
+// NOTE(dan): the share of the bucket each priority has to leave for the ones above it
+static f64 request_budget_reserves[RequestPriority_Count] = { 0.0, 0.25, 0.5 };
+
+static void set_request_budget_limit(RequestBudget *budget, u32 limit)
+{
+    budget->capacity = limit*REQUEST_BUDGET_HEADROOM;
+    budget->refill_per_sec = budget->capacity / REQUEST_BUDGET_WINDOW_SECS;
+    if (budget->tokens > budget->capacity)
+    {
+        budget->tokens = budget->capacity;
+    }
+}
+
+static void init_request_budget(RequestBudget *budget, f64 now)
+{
+    budget->tokens = REQUEST_BUDGET_DEFAULT_LIMIT*REQUEST_BUDGET_HEADROOM;
+    budget->last_refill = now;
+    budget->blocked_until = 0.0;
+    budget->requests = 0;
+    budget->throttled = 0;
+    set_request_budget_limit(budget, REQUEST_BUDGET_DEFAULT_LIMIT);
+}
+
+static void refill_request_budget(RequestBudget *budget, f64 now)
+{
+    if (now > budget->last_refill)
+    {
+        budget->tokens += (now - budget->last_refill)*budget->refill_per_sec;
+        if (budget->tokens > budget->capacity)
+        {
+            budget->tokens = budget->capacity;
+        }
+        budget->last_refill = now;
+    }
+}
+
+// NOTE(dan): takes a token and returns zero, or returns how many seconds to wait before asking again
+static f64 acquire_request(RequestBudget *budget, RequestPriority priority, f64 now)
+{
+    f64 wait = 0.0;
+
+    begin_ticket_mutex(&budget->mutex);
+    refill_request_budget(budget, now);
+
+    f64 needed = 1.0 + budget->capacity*request_budget_reserves[priority];
+    if (now < budget->blocked_until)
+    {
+        wait = budget->blocked_until - now;
+    }
+    else if (budget->tokens >= needed)
+    {
+        budget->tokens -= 1.0;
+        ++budget->requests;
+    }
+    else
+    {
+        wait = (needed - budget->tokens) / budget->refill_per_sec;
+    }
+
+    if (wait > REQUEST_BUDGET_MAX_WAIT_SECS)
+    {
+        wait = REQUEST_BUDGET_MAX_WAIT_SECS;
+    }
+    end_ticket_mutex(&budget->mutex);
+
+    return wait;
+}
+
+// NOTE(dan): whether acquire_request would take a token now, without taking it
+static b32 request_budget_available(RequestBudget *budget, RequestPriority priority, f64 now)
+{
+    begin_ticket_mutex(&budget->mutex);
+    refill_request_budget(budget, now);
+
+    f64 needed = 1.0 + budget->capacity*request_budget_reserves[priority];
+    b32 available = (now >= budget->blocked_until && budget->tokens >= needed);
+    end_ticket_mutex(&budget->mutex);
+
+    return available;
+}
+
+// NOTE(dan): the API's view wins when it has fewer requests left than we think,
+// other clients may share the limit. reset_in is how long until it's full again
+static void update_request_budget(RequestBudget *budget, f64 now, u32 limit, u32 remaining, f64 reset_in)
+{
+    begin_ticket_mutex(&budget->mutex);
+    refill_request_budget(budget, now);
+
+    if (limit)
+    {
+        set_request_budget_limit(budget, limit);
+    }
+
+    if (budget->tokens > remaining)
+    {
+        budget->tokens = remaining;
+    }
+
+    if (!remaining && reset_in > 0.0)
+    {
+        budget->blocked_until = now + reset_in;
+    }
+    end_ticket_mutex(&budget->mutex);
+}
+
+// NOTE(dan): a 429, the bucket is empty whatever we thought
+static void throttle_request_budget(RequestBudget *budget, f64 now, f64 retry_in)
+{
+    begin_ticket_mutex(&budget->mutex);
+    refill_request_budget(budget, now);
+
+    budget->tokens = 0.0;
+    if (budget->blocked_until < now + retry_in)
+    {
+        budget->blocked_until = now + retry_in;
+    }
+    ++budget->throttled;
+    end_ticket_mutex(&budget->mutex);
+}
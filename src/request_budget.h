@@ -0,0 +1,33 @@
+// NOTE(dan): every request takes a token from one bucket that refills at the rate
+// the API allows. lower priorities have to leave a reserve in the bucket, so when
+// tokens run short live-status polls still go out and logos and warm-up wait.
+// the API's Ratelimit-* headers correct the bucket whenever a response has them
+#define REQUEST_BUDGET_DEFAULT_LIMIT    120     // NOTE(dan): requests per window until the API says otherwise
+#define REQUEST_BUDGET_WINDOW_SECS      60.0
+#define REQUEST_BUDGET_HEADROOM         0.9     // NOTE(dan): stay just under the limit
+#define REQUEST_BUDGET_MAX_WAIT_SECS    60.0
+
+enum RequestPriority
+{
+    RequestPriority_Poll,
+    RequestPriority_Logo,
+    RequestPriority_Warmup,
+
+    RequestPriority_Count,
+};
+
+struct RequestBudget
+{
+    TicketMutex mutex;
+
+    f64 capacity;
+    f64 tokens;
+    f64 refill_per_sec;
+    f64 last_refill;
+
+    // NOTE(dan): set when the API ran out or answered 429, nothing goes out before it
+    f64 blocked_until;
+
+    u64 requests;
+    u64 throttled;
+};
@@ -0,0 +1,668 @@
+inline u64 hash_channel_name(char *name)
+{
+    // NOTE(dan): FNV-1a, 64 bits so 100k channels don't collide
+    u64 hash = 14695981039346656037ULL;
+    for (char *at = name; *at; ++at)
+    {
+        hash ^= (u8)*at;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline u32 get_session_record_checksum(SessionRecord *record)
+{
+    u32 hash = 2166136261;
+    u8 *at = (u8 *)record;
+    for (u32 byte_index = 0; byte_index < (u32)((u8 *)&record->checksum - (u8 *)record); ++byte_index)
+    {
+        hash ^= at[byte_index];
+        hash *= 16777619;
+    }
+    return hash | 1;
+}
+
+inline SessionRecord *get_segment_records(HistorySegmentHeader *header)
+{
+    SessionRecord *records = (SessionRecord *)(header + 1);
+    return records;
+}
+
+static void build_history_filename(SessionHistory *history, char *filename, char *out)
+{
+    snprintf(out, HISTORY_MAX_PATH, "%s%s", history->path, filename);
+}
+
+static void build_history_segment_filename(SessionHistory *history, u64 segment_index, char *out)
+{
+    snprintf(out, HISTORY_MAX_PATH, "%ssessions.%06u.log", history->path, (u32)segment_index);
+}
+
+// NOTE(dan): with the mutex held. the active segment is always mapped, older ones are
+// mapped on demand, least recently used first out
+static HistorySegmentHeader *map_history_segment(SessionHistory *history, u64 segment_index)
+{
+    HistorySegmentHeader *header = 0;
+
+    if (history->active.file.memory && history->active.segment_index == segment_index)
+    {
+        header = (HistorySegmentHeader *)history->active.file.memory;
+    }
+    else
+    {
+        HistoryMappedSegment *victim = history->mapped;
+        for (u32 mapped_index = 0; mapped_index < HISTORY_MAPPED_SEGMENTS; ++mapped_index)
+        {
+            HistoryMappedSegment *mapped = history->mapped + mapped_index;
+            if (mapped->file.memory && mapped->segment_index == segment_index)
+            {
+                mapped->last_used = ++history->use_clock;
+                header = (HistorySegmentHeader *)mapped->file.memory;
+                break;
+            }
+
+            if (!mapped->file.memory || (victim->file.memory && mapped->last_used < victim->last_used))
+            {
+                victim = mapped;
+            }
+        }
+
+        if (!header)
+        {
+            if (victim->file.memory)
+            {
+                platform.unmap_file(&victim->file);
+            }
+
+            char filename[HISTORY_MAX_PATH];
+            build_history_segment_filename(history, segment_index, filename);
+            if (platform.map_file(filename, HISTORY_SEGMENT_SIZE, false, &victim->file))
+            {
+                HistorySegmentHeader *mapped_header = (HistorySegmentHeader *)victim->file.memory;
+                if (mapped_header->magic == HISTORY_SEGMENT_MAGIC &&
+                    mapped_header->version == HISTORY_VERSION &&
+                    mapped_header->record_size == sizeof(SessionRecord) &&
+                    mapped_header->first_seq == segment_index*HISTORY_SEGMENT_RECORDS)
+                {
+                    victim->segment_index = segment_index;
+                    victim->last_used = ++history->use_clock;
+                    header = mapped_header;
+                }
+                else
+                {
+                    platform.unmap_file(&victim->file);
+                }
+            }
+        }
+    }
+    return header;
+}
+
+// NOTE(dan): with the mutex held, zero for records that were deleted or never written
+static SessionRecord *get_session_record(SessionHistory *history, u64 seq)
+{
+    SessionRecord *record = 0;
+    if (seq != HISTORY_NO_RECORD && seq >= history->first_seq && seq < history->next_seq)
+    {
+        HistorySegmentHeader *header = map_history_segment(history, seq / HISTORY_SEGMENT_RECORDS);
+        if (header)
+        {
+            record = get_segment_records(header) + (seq % HISTORY_SEGMENT_RECORDS);
+        }
+    }
+    return record;
+}
+
+static u32 find_history_channel(SessionHistory *history, u64 name_hash, b32 add)
+{
+    u32 slot = HISTORY_NO_SLOT;
+
+    u32 table_index = (u32)name_hash & (HISTORY_CHANNEL_TABLE_SIZE - 1);
+    for (;;)
+    {
+        u32 test_slot = history->channel_table[table_index];
+        if (test_slot == HISTORY_NO_SLOT)
+        {
+            if (add && history->heads_header.num_channels < HISTORY_MAX_CHANNELS)
+            {
+                slot = history->heads_header.num_channels++;
+                HistoryChannel *channel = history->channels + slot;
+                channel->name_hash = name_hash;
+                channel->last_seq = HISTORY_NO_RECORD;
+                channel->expired_seconds = 0;
+                channel->expired_sessions = 0;
+
+                history->channel_table[table_index] = slot;
+                history->heads_dirty = true;
+            }
+            break;
+        }
+
+        if (history->channels[test_slot].name_hash == name_hash)
+        {
+            slot = test_slot;
+            break;
+        }
+        table_index = (table_index + 1) & (HISTORY_CHANNEL_TABLE_SIZE - 1);
+    }
+    return slot;
+}
+
+static u32 intern_history_game(SessionHistory *history, char *game)
+{
+    u32 handle = HISTORY_NO_GAME;
+
+    u32 hash = 2166136261;
+    for (char *at = game; *at; ++at)
+    {
+        hash ^= (u8)*at;
+        hash *= 16777619;
+    }
+
+    u32 table_index = hash & (HISTORY_GAME_TABLE_SIZE - 1);
+    for (;;)
+    {
+        u32 test_handle = history->game_table[table_index];
+        if (test_handle == HISTORY_NO_GAME)
+        {
+            if (history->games_header.num_games < HISTORY_MAX_GAMES && string_length(game) < array_count(history->games[0]))
+            {
+                handle = history->games_header.num_games++;
+                copy_string(game, history->games[handle]);
+
+                history->game_table[table_index] = handle;
+                history->games_dirty = true;
+            }
+            break;
+        }
+
+        if (strings_equal(history->games[test_handle], game))
+        {
+            handle = test_handle;
+            break;
+        }
+        table_index = (table_index + 1) & (HISTORY_GAME_TABLE_SIZE - 1);
+    }
+    return handle;
+}
+
+// NOTE(dan): a new segment starts from an empty file, whatever an old one with the same number had is gone
+static b32 open_active_history_segment(SessionHistory *history, u64 segment_index, b32 fresh)
+{
+    char filename[HISTORY_MAX_PATH];
+    build_history_segment_filename(history, segment_index, filename);
+
+    if (fresh)
+    {
+        platform.delete_file(filename);
+    }
+
+    HistoryMappedSegment *active = &history->active;
+    b32 opened = platform.map_file(filename, HISTORY_SEGMENT_SIZE, true, &active->file);
+    if (opened)
+    {
+        active->segment_index = segment_index;
+
+        HistorySegmentHeader *header = (HistorySegmentHeader *)active->file.memory;
+        header->magic = HISTORY_SEGMENT_MAGIC;
+        header->version = HISTORY_VERSION;
+        header->first_seq = segment_index*HISTORY_SEGMENT_RECORDS;
+        header->num_records = (u32)(history->next_seq - header->first_seq);
+        header->record_size = sizeof(SessionRecord);
+    }
+    return opened;
+}
+
+static void save_history_heads(SessionHistory *history)
+{
+    char filename[HISTORY_MAX_PATH];
+    build_history_filename(history, "heads.dat", filename);
+
+    HistoryHeadsHeader *header = &history->heads_header;
+    header->magic = HISTORY_HEADS_MAGIC;
+    header->version = HISTORY_VERSION;
+    header->first_seq = history->first_seq;
+    header->covered_seq = history->next_seq;
+
+    u32 size = (u32)(sizeof(HistoryHeadsHeader) + header->num_channels*sizeof(HistoryChannel));
+    if (platform.write_entire_file(filename, header, size))
+    {
+        history->heads_dirty = false;
+    }
+}
+
+static void save_history_games(SessionHistory *history)
+{
+    char filename[HISTORY_MAX_PATH];
+    build_history_filename(history, "games.dat", filename);
+
+    HistoryGamesHeader *header = &history->games_header;
+    header->magic = HISTORY_GAMES_MAGIC;
+    header->version = HISTORY_VERSION;
+
+    u32 size = (u32)(sizeof(HistoryGamesHeader) + header->num_games*sizeof(history->games[0]));
+    if (platform.write_entire_file(filename, header, size))
+    {
+        history->games_dirty = false;
+    }
+}
+
+static void load_history_heads(SessionHistory *history)
+{
+    char filename[HISTORY_MAX_PATH];
+    build_history_filename(history, "heads.dat", filename);
+
+    LoadedFile file = platform.load_file(filename);
+    HistoryHeadsHeader *header = (HistoryHeadsHeader *)file.contents;
+    if (file.size >= sizeof(HistoryHeadsHeader) &&
+        header->magic == HISTORY_HEADS_MAGIC &&
+        header->version == HISTORY_VERSION &&
+        header->num_channels <= HISTORY_MAX_CHANNELS &&
+        file.size >= sizeof(HistoryHeadsHeader) + header->num_channels*sizeof(HistoryChannel))
+    {
+        history->first_seq = header->first_seq;
+        history->next_seq = header->covered_seq;
+
+        HistoryChannel *channels = (HistoryChannel *)(header + 1);
+        for (u32 slot = 0; slot < header->num_channels; ++slot)
+        {
+            u32 added = find_history_channel(history, channels[slot].name_hash, true);
+            if (added != HISTORY_NO_SLOT)
+            {
+                history->channels[added] = channels[slot];
+            }
+        }
+    }
+    platform.unload_file(file);
+}
+
+static void load_history_games(SessionHistory *history)
+{
+    char filename[HISTORY_MAX_PATH];
+    build_history_filename(history, "games.dat", filename);
+
+    LoadedFile file = platform.load_file(filename);
+    HistoryGamesHeader *header = (HistoryGamesHeader *)file.contents;
+    if (file.size >= sizeof(HistoryGamesHeader) &&
+        header->magic == HISTORY_GAMES_MAGIC &&
+        header->version == HISTORY_VERSION &&
+        header->num_games <= HISTORY_MAX_GAMES &&
+        file.size >= sizeof(HistoryGamesHeader) + header->num_games*sizeof(history->games[0]))
+    {
+        char (*games)[128] = (char (*)[128])(header + 1);
+        for (u32 handle = 0; handle < header->num_games; ++handle)
+        {
+            games[handle][array_count(games[handle]) - 1] = 0;
+            intern_history_game(history, games[handle]);
+        }
+    }
+    history->games_dirty = false;
+    platform.unload_file(file);
+}
+
+// NOTE(dan): takes back the records written since the heads were saved, up to the
+// first one that doesn't check out
+static void recover_history_records(SessionHistory *history)
+{
+    for (;;)
+    {
+        u64 segment_index = history->next_seq / HISTORY_SEGMENT_RECORDS;
+        HistorySegmentHeader *header = map_history_segment(history, segment_index);
+        if (!header)
+        {
+            break;
+        }
+
+        SessionRecord *records = get_segment_records(header);
+        u32 record_index = (u32)(history->next_seq % HISTORY_SEGMENT_RECORDS);
+        for ( ; record_index < HISTORY_SEGMENT_RECORDS; ++record_index)
+        {
+            SessionRecord *record = records + record_index;
+            if (record->checksum != get_session_record_checksum(record) ||
+                record->channel_slot >= history->heads_header.num_channels)
+            {
+                break;
+            }
+
+            history->channels[record->channel_slot].last_seq = history->next_seq++;
+            history->heads_dirty = true;
+        }
+
+        if (record_index < HISTORY_SEGMENT_RECORDS)
+        {
+            break;
+        }
+    }
+
+    // NOTE(dan): none of the mapped segments is the active one yet
+    for (u32 mapped_index = 0; mapped_index < HISTORY_MAPPED_SEGMENTS; ++mapped_index)
+    {
+        HistoryMappedSegment *mapped = history->mapped + mapped_index;
+        if (mapped->file.memory)
+        {
+            platform.unmap_file(&mapped->file);
+        }
+    }
+}
+
+// NOTE(dan): path is the directory the history lives in, with the trailing separator
+static void init_session_history(SessionHistory *history, char *path)
+{
+    copy_string(path, history->path);
+
+    for (u32 table_index = 0; table_index < HISTORY_CHANNEL_TABLE_SIZE; ++table_index)
+    {
+        history->channel_table[table_index] = HISTORY_NO_SLOT;
+    }
+    for (u32 table_index = 0; table_index < HISTORY_GAME_TABLE_SIZE; ++table_index)
+    {
+        history->game_table[table_index] = HISTORY_NO_GAME;
+    }
+
+    load_history_heads(history);
+    load_history_games(history);
+    recover_history_records(history);
+
+    u64 segment_index = history->next_seq / HISTORY_SEGMENT_RECORDS;
+    b32 fresh = (history->next_seq % HISTORY_SEGMENT_RECORDS) == 0;
+    open_active_history_segment(history, segment_index, fresh);
+    history->flushed_seq = history->next_seq;
+
+    for (u32 stream_index = 0; stream_index < MAX_STREAMS; ++stream_index)
+    {
+        history->stream_slots[stream_index] = HISTORY_NO_SLOT;
+    }
+}
+
+// NOTE(dan): before the update thread starts
+static void register_history_stream(SessionHistory *history, u32 stream_index, char *name)
+{
+    u32 slot = find_history_channel(history, hash_channel_name(name), true);
+    history->stream_slots[stream_index] = slot;
+
+    FinishedSession *last_session = history->last_sessions + stream_index;
+    last_session->start = 0;
+    last_session->end = 0;
+    if (slot != HISTORY_NO_SLOT)
+    {
+        begin_ticket_mutex(&history->mutex);
+        SessionRecord *record = get_session_record(history, history->channels[slot].last_seq);
+        if (record)
+        {
+            last_session->start = record->start;
+            last_session->end = record->end;
+        }
+        end_ticket_mutex(&history->mutex);
+    }
+}
+
+// NOTE(dan): runs on the low priority queue. folds the segments past the retention
+// into the channel totals and deletes them, the heads are saved with the next flush
+static PLATFORM_WORK_QUEUE_CALLBACK(do_history_compaction_work)
+{
+    SessionHistory *history = (SessionHistory *)data;
+
+    begin_ticket_mutex(&history->mutex);
+    while ((history->next_seq / HISTORY_SEGMENT_RECORDS) - (history->first_seq / HISTORY_SEGMENT_RECORDS) >= HISTORY_MAX_SEGMENTS)
+    {
+        u64 segment_index = history->first_seq / HISTORY_SEGMENT_RECORDS;
+        HistorySegmentHeader *header = map_history_segment(history, segment_index);
+        if (header)
+        {
+            SessionRecord *records = get_segment_records(header);
+            for (u32 record_index = 0; record_index < header->num_records; ++record_index)
+            {
+                SessionRecord *record = records + record_index;
+                if (record->channel_slot < history->heads_header.num_channels)
+                {
+                    HistoryChannel *channel = history->channels + record->channel_slot;
+                    channel->expired_seconds += record->end - record->start;
+                    ++channel->expired_sessions;
+                    if (channel->last_seq == header->first_seq + record_index)
+                    {
+                        channel->last_seq = HISTORY_NO_RECORD;
+                    }
+                }
+            }
+        }
+
+        for (u32 mapped_index = 0; mapped_index < HISTORY_MAPPED_SEGMENTS; ++mapped_index)
+        {
+            HistoryMappedSegment *mapped = history->mapped + mapped_index;
+            if (mapped->file.memory && mapped->segment_index == segment_index)
+            {
+                platform.unmap_file(&mapped->file);
+            }
+        }
+
+        char filename[HISTORY_MAX_PATH];
+        build_history_segment_filename(history, segment_index, filename);
+        platform.delete_file(filename);
+
+        history->first_seq = (segment_index + 1)*HISTORY_SEGMENT_RECORDS;
+        history->heads_dirty = true;
+    }
+    history->compaction_queued = false;
+    end_ticket_mutex(&history->mutex);
+}
+
+// NOTE(dan): with the mutex held, makes the records durable with one flush
+static void flush_session_history_locked(SessionHistory *history)
+{
+    if (history->next_seq > history->flushed_seq && history->active.file.memory)
+    {
+        HistorySegmentHeader *header = (HistorySegmentHeader *)history->active.file.memory;
+        header->num_records = (u32)(history->next_seq - header->first_seq);
+
+        u64 size = sizeof(HistorySegmentHeader) + header->num_records*sizeof(SessionRecord);
+        platform.flush_mapped_file(&history->active.file, 0, size);
+        history->flushed_seq = history->next_seq;
+    }
+
+    // NOTE(dan): only after the records they point to are on disk
+    if (history->heads_dirty)
+    {
+        save_history_heads(history);
+    }
+    if (history->games_dirty)
+    {
+        save_history_games(history);
+    }
+}
+
+// NOTE(dan): with the mutex held. returns true when the compaction has to be queued,
+// that happens after the mutex is released since the work can run right away
+static b32 append_session_record(SessionHistory *history, u32 slot, u64 start, u64 end, u32 game_handle)
+{
+    b32 start_compaction = false;
+    if (history->active.file.memory && (history->next_seq / HISTORY_SEGMENT_RECORDS) != history->active.segment_index)
+    {
+        // NOTE(dan): the active segment is full. the heads saved in the flush cover it
+        history->heads_dirty = true;
+        flush_session_history_locked(history);
+        platform.unmap_file(&history->active.file);
+
+        open_active_history_segment(history, history->next_seq / HISTORY_SEGMENT_RECORDS, true);
+
+        if (!history->compaction_queued &&
+            (history->next_seq / HISTORY_SEGMENT_RECORDS) - (history->first_seq / HISTORY_SEGMENT_RECORDS) >= HISTORY_MAX_SEGMENTS)
+        {
+            history->compaction_queued = true;
+            start_compaction = true;
+        }
+    }
+
+    if (history->active.file.memory)
+    {
+        HistoryChannel *channel = history->channels + slot;
+        u64 seq = history->next_seq++;
+
+        SessionRecord *record = get_session_record(history, seq);
+        record->start = start;
+        record->end = end;
+        record->channel_slot = slot;
+        record->game_handle = game_handle;
+
+        // NOTE(dan): the jump skips as far as the jump of the previous record's jump
+        // when the two jumps before it spanned the same number of records
+        SessionRecord *prev = get_session_record(history, channel->last_seq);
+        if (prev)
+        {
+            record->prev = channel->last_seq;
+            record->depth = prev->depth + 1;
+            record->jump = channel->last_seq;
+
+            SessionRecord *jump = get_session_record(history, prev->jump);
+            SessionRecord *jump_jump = jump ? get_session_record(history, jump->jump) : 0;
+            if (jump_jump && (prev->depth - jump->depth) == (jump->depth - jump_jump->depth))
+            {
+                record->jump = jump->jump;
+            }
+        }
+        else
+        {
+            record->prev = HISTORY_NO_RECORD;
+            record->jump = HISTORY_NO_RECORD;
+            record->depth = 0;
+        }
+
+        record->checksum = get_session_record_checksum(record);
+        channel->last_seq = seq;
+    }
+    return start_compaction;
+}
+
+static void close_open_session(SessionHistory *history, u32 stream_index, u64 end)
+{
+    OpenSession *session = history->open_sessions + stream_index;
+    u32 slot = history->stream_slots[stream_index];
+    if (session->open && slot != HISTORY_NO_SLOT)
+    {
+        begin_ticket_mutex(&history->mutex);
+        b32 start_compaction = append_session_record(history, slot, session->start, end, session->game_handle);
+        end_ticket_mutex(&history->mutex);
+
+        history->last_sessions[stream_index].start = session->start;
+        history->last_sessions[stream_index].end = end;
+
+        if (start_compaction)
+        {
+            platform.add_work(platform.low_priority_queue, do_history_compaction_work, history);
+        }
+    }
+    session->open = false;
+}
+
+// NOTE(dan): before the update thread starts, for a channel that was live when the
+// program stopped. its session goes on as if it never had
+static void resume_open_session(SessionHistory *history, u32 stream_index, u64 start, char *game)
+{
+    OpenSession *session = history->open_sessions + stream_index;
+    session->open = true;
+    session->start = start;
+    session->game_handle = intern_history_game(history, game);
+}
+
+// NOTE(dan): runs on the update thread, its own consumer of the transition log
+static void update_session_history(SessionHistory *history, TransitionLog *log)
+{
+    TransitionEvent event;
+    while (pop_transition_event(log, history->transition_consumer, &event))
+    {
+        if (event.stream_index >= MAX_STREAMS && event.type != TransitionEventType_CycleEnd)
+        {
+            continue;
+        }
+
+        OpenSession *session = history->open_sessions + event.stream_index;
+        switch (event.type)
+        {
+            case TransitionEventType_WentOnline:
+            {
+                session->open = true;
+                session->start = event.time;
+                session->game_handle = intern_history_game(history, event.game);
+            } break;
+
+            case TransitionEventType_GameChanged:
+            {
+                close_open_session(history, event.stream_index, event.time);
+
+                session->open = true;
+                session->start = event.time;
+                session->game_handle = intern_history_game(history, event.game);
+            } break;
+
+            case TransitionEventType_WentOffline:
+            {
+                close_open_session(history, event.stream_index, event.time);
+            } break;
+
+            case TransitionEventType_CycleEnd:
+            {
+                begin_ticket_mutex(&history->mutex);
+                flush_session_history_locked(history);
+                end_ticket_mutex(&history->mutex);
+            } break;
+
+            default:
+            {
+            } break;
+        }
+    }
+}
+
+// NOTE(dan): the stream's latest finished session, false when it has none on record
+static b32 get_last_session(SessionHistory *history, u32 stream_index, SessionRecord *result)
+{
+    b32 found = false;
+
+    u32 slot = history->stream_slots[stream_index];
+    if (slot != HISTORY_NO_SLOT)
+    {
+        begin_ticket_mutex(&history->mutex);
+        SessionRecord *record = get_session_record(history, history->channels[slot].last_seq);
+        if (record)
+        {
+            *result = *record;
+            found = true;
+        }
+        end_ticket_mutex(&history->mutex);
+    }
+    return found;
+}
+
+// NOTE(dan): the session the stream was live in at the given time, O(log n) records.
+// starts only get later along a channel's chain, so a jump is taken whenever it
+// still lands after the time
+static b32 find_session_at(SessionHistory *history, u32 stream_index, u64 time, SessionRecord *result)
+{
+    b32 found = false;
+
+    u32 slot = history->stream_slots[stream_index];
+    if (slot != HISTORY_NO_SLOT)
+    {
+        begin_ticket_mutex(&history->mutex);
+        SessionRecord *record = get_session_record(history, history->channels[slot].last_seq);
+        while (record && record->start > time)
+        {
+            SessionRecord *jump = get_session_record(history, record->jump);
+            if (jump && jump->start > time)
+            {
+                record = jump;
+            }
+            else
+            {
+                record = get_session_record(history, record->prev);
+            }
+        }
+
+        if (record && time <= record->end)
+        {
+            *result = *record;
+            found = true;
+        }
+        end_ticket_mutex(&history->mutex);
+    }
+    return found;
+}
@@ -0,0 +1,144 @@
+// NOTE(dan): every stream session ends up as one fixed-size record in an append-only
+// log. a session is split where the game changes and written when it ends, so
+// records are in end time order. the log is made of memory-mapped segment files of
+// HISTORY_SEGMENT_RECORDS records each, a record is addressed by its sequence number
+// across all segments. the segments past the retention are folded into per-channel
+// totals and deleted in the background.
+//
+// each channel's records are chained backwards, and every record also has a jump
+// pointer (the skew binary scheme from Myers' applicative random-access stacks), so
+// the session of a channel at any given time is found in O(log n) records. the
+// only per-channel state in memory is the chain head and the totals.
+//
+// records are flushed once per cycle. the segment header only counts the flushed
+// records, after a crash the records past it are taken back while their checksums
+// hold. the channel heads are saved when a segment is rotated or compacted, and
+// rebuilt at startup from the records written since then
+#define HISTORY_SEGMENT_MAGIC       0x47534857 // NOTE(dan): "WHSG"
+#define HISTORY_HEADS_MAGIC         0x44485357 // NOTE(dan): "WSHD"
+#define HISTORY_GAMES_MAGIC         0x4D474857 // NOTE(dan): "WHGM"
+#define HISTORY_VERSION             1
+
+#define HISTORY_SEGMENT_RECORDS     (64 * 1024)
+#define HISTORY_MAX_SEGMENTS        64          // NOTE(dan): retention, about four million sessions
+#define HISTORY_MAPPED_SEGMENTS     4           // NOTE(dan): older segments mapped for lookups at once
+#define HISTORY_MAX_CHANNELS        (16 * MAX_STREAMS) // NOTE(dan): channels dropped from streams.txt keep their slot
+#define HISTORY_CHANNEL_TABLE_SIZE  (2 * HISTORY_MAX_CHANNELS) // NOTE(dan): has to be a power of two
+#define HISTORY_MAX_GAMES           2048        // NOTE(dan): sessions of games past that are kept without one
+#define HISTORY_GAME_TABLE_SIZE     (2 * HISTORY_MAX_GAMES) // NOTE(dan): has to be a power of two
+
+#define HISTORY_MAX_PATH            260
+
+#define HISTORY_NO_RECORD           0xFFFFFFFFFFFFFFFFULL
+#define HISTORY_NO_SLOT             0xFFFFFFFF
+#define HISTORY_NO_GAME             0xFFFFFFFF
+
+struct SessionRecord
+{
+    u64 start;  // NOTE(dan): unix seconds
+    u64 end;
+
+    u64 prev;   // NOTE(dan): the channel's previous record
+    u64 jump;   // NOTE(dan): an earlier one, for skipping back
+    u32 depth;  // NOTE(dan): how many records of the channel come before
+
+    u32 channel_slot;
+    u32 game_handle;
+    u32 checksum;
+};
+
+struct HistorySegmentHeader
+{
+    u32 magic;
+    u32 version;
+    u64 first_seq;
+    u32 num_records;    // NOTE(dan): the flushed ones
+    u32 record_size;
+};
+
+#define HISTORY_SEGMENT_SIZE (sizeof(HistorySegmentHeader) + HISTORY_SEGMENT_RECORDS*sizeof(SessionRecord))
+
+struct HistoryChannel
+{
+    u64 name_hash;
+    u64 last_seq;
+
+    // NOTE(dan): what the deleted segments had for the channel
+    u64 expired_seconds;
+    u32 expired_sessions;
+    u32 padding;
+};
+
+struct HistoryHeadsHeader
+{
+    u32 magic;
+    u32 version;
+    u32 num_channels;
+    u32 padding;
+
+    u64 first_seq;      // NOTE(dan): the oldest record not deleted
+    u64 covered_seq;    // NOTE(dan): the heads include every record before it
+};
+
+struct HistoryGamesHeader
+{
+    u32 magic;
+    u32 version;
+    u32 num_games;
+    u32 padding;
+};
+
+struct HistoryMappedSegment
+{
+    u64 segment_index;
+    u64 last_used;
+    PlatformMappedFile file;
+};
+
+struct OpenSession
+{
+    b32 open;
+    u64 start;
+    u32 game_handle;
+};
+
+struct FinishedSession
+{
+    u64 start;  // NOTE(dan): 0 when the channel has none on record
+    u64 end;
+};
+
+struct SessionHistory
+{
+    TicketMutex mutex;
+    char path[HISTORY_MAX_PATH];    // NOTE(dan): directory, with the trailing separator
+
+    u64 first_seq;
+    u64 next_seq;
+    u64 flushed_seq;
+    u64 use_clock;
+
+    b32 compaction_queued;
+    b32 heads_dirty;
+    b32 games_dirty;
+
+    HistoryMappedSegment active;
+    HistoryMappedSegment mapped[HISTORY_MAPPED_SEGMENTS];
+
+    u32 transition_consumer;
+    u32 stream_slots[MAX_STREAMS];
+    OpenSession open_sessions[MAX_STREAMS];
+
+    // NOTE(dan): only the update thread touches these, it publishes them in the stream
+    // snapshot so readers never wait on the mutex while a flush hits the disk
+    FinishedSession last_sessions[MAX_STREAMS];
+
+    // NOTE(dan): the headers sit right in front of their arrays, so the files are written straight from here
+    HistoryHeadsHeader heads_header;
+    HistoryChannel channels[HISTORY_MAX_CHANNELS];
+    u32 channel_table[HISTORY_CHANNEL_TABLE_SIZE];
+
+    HistoryGamesHeader games_header;
+    char games[HISTORY_MAX_GAMES][128];
+    u32 game_table[HISTORY_GAME_TABLE_SIZE];
+};
@@ -356,6 +356,11 @@ STBIDEF stbi_uc *stbi_load               (char              const *filename,
 STBIDEF stbi_uc *stbi_load_from_memory   (stbi_uc           const *buffer, int len   , int *x, int *y, int *channels_in_file, int desired_channels);
 STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk  , void *user, int *x, int *y, int *channels_in_file, int desired_channels);
 
+// same as stbi_load_from_memory, but a JPEG may be decoded at 1/2, 1/4 or 1/8
+// scale (reduced-size IDCT) as long as the result is at least min_x by min_y;
+// other formats are decoded at full size. *x and *y report the decoded size.
+STBIDEF stbi_uc *stbi_load_from_memory_scaled(stbi_uc const *buffer, int len, int *x, int *y, int *channels_in_file, int desired_channels, int min_x, int min_y);
+
 #ifndef STBI_NO_STDIO
 STBIDEF stbi_uc *stbi_load_from_file   (FILE *f, int *x, int *y, int *channels_in_file, int desired_channels);
 // for stbi_load_from_file, file pointer is left pointing immediately after image
@@ -692,6 +697,8 @@ typedef struct
 
    stbi_uc *img_buffer, *img_buffer_end;
    stbi_uc *img_buffer_original, *img_buffer_original_end;
+
+   int scale_min_x, scale_min_y; // smallest acceptable size for scaled decoding, 0 = full size
 } stbi__context;
 
 
@@ -704,6 +711,7 @@ static void stbi__start_mem(stbi__context *s, stbi_uc const *buffer, int len)
    s->read_from_callbacks = 0;
    s->img_buffer = s->img_buffer_original = (stbi_uc *) buffer;
    s->img_buffer_end = s->img_buffer_original_end = (stbi_uc *) buffer+len;
+   s->scale_min_x = s->scale_min_y = 0;
 }
 
 // initialize a callback-based context
@@ -716,6 +724,7 @@ static void stbi__start_callbacks(stbi__context *s, stbi_io_callbacks *c, void *
    s->img_buffer_original = s->buffer_start;
    stbi__refill_buffer(s);
    s->img_buffer_original_end = s->img_buffer_end;
+   s->scale_min_x = s->scale_min_y = 0;
 }
 
 #ifndef STBI_NO_STDIO
@@ -1198,6 +1207,15 @@ STBIDEF stbi_uc *stbi_load_from_memory(stbi_uc const *buffer, int len, int *x, i
    return stbi__load_and_postprocess_8bit(&s,x,y,comp,req_comp);
 }
 
+STBIDEF stbi_uc *stbi_load_from_memory_scaled(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, int min_x, int min_y)
+{
+   stbi__context s;
+   stbi__start_mem(&s,buffer,len);
+   s.scale_min_x = min_x;
+   s.scale_min_y = min_y;
+   return stbi__load_and_postprocess_8bit(&s,x,y,comp,req_comp);
+}
+
 STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk, void *user, int *x, int *y, int *comp, int req_comp)
 {
    stbi__context s;
@@ -1697,6 +1715,9 @@ typedef struct
    int scan_n, order[4];
    int restart_interval, todo;
 
+   int scale_shift; // output is decoded at 1/(1<<scale_shift) size
+   int block_size;  // 8 >> scale_shift pixels per block side
+
 // kernels
    void (*idct_block_kernel)(stbi_uc *out, int out_stride, short data[64]);
    void (*YCbCr_to_RGB_kernel)(stbi_uc *out, const stbi_uc *y, const stbi_uc *pcb, const stbi_uc *pcr, int count, int step);
@@ -2211,6 +2232,65 @@ static void stbi__idct_block(stbi_uc *out, int out_stride, short data[64])
    }
 }
 
+// reduced-size IDCTs for scaled decoding. only the lowest NxN coefficients
+// contribute, evaluated at the centers of an NxN output grid (the same idea
+// as IJG's jidctred). table[x][u] = c(u)/2 * cos((2x+1)*u*pi/(2N)), 1<<12
+static const int stbi__idct_table_4x4[16] =
+{
+   stbi__f2f(0.353553391f), stbi__f2f( 0.461939766f), stbi__f2f( 0.353553391f), stbi__f2f( 0.191341716f),
+   stbi__f2f(0.353553391f), stbi__f2f( 0.191341716f), stbi__f2f(-0.353553391f), stbi__f2f(-0.461939766f),
+   stbi__f2f(0.353553391f), stbi__f2f(-0.191341716f), stbi__f2f(-0.353553391f), stbi__f2f( 0.461939766f),
+   stbi__f2f(0.353553391f), stbi__f2f(-0.461939766f), stbi__f2f( 0.353553391f), stbi__f2f(-0.191341716f),
+};
+
+static const int stbi__idct_table_2x2[4] =
+{
+   stbi__f2f(0.353553391f), stbi__f2f( 0.353553391f),
+   stbi__f2f(0.353553391f), stbi__f2f(-0.353553391f),
+};
+
+static void stbi__idct_scaled(stbi_uc *out, int out_stride, short data[64], int const *table, int n)
+{
+   int i,j,k,tmp[16];
+
+   // columns: keep 2 extra bits of precision, like the full IDCT
+   for (j=0; j < n; ++j) {
+      for (i=0; i < n; ++i) {
+         int t = 0;
+         for (k=0; k < n; ++k)
+            t += table[j*n+k] * data[k*8+i];
+         tmp[j*4+i] = (t + 512) >> 10;
+      }
+   }
+
+   // rows: remove the remaining 1<<14, round, and bias to 0..255
+   for (j=0; j < n; ++j, out += out_stride) {
+      for (i=0; i < n; ++i) {
+         int t = 0;
+         for (k=0; k < n; ++k)
+            t += table[i*n+k] * tmp[j*4+k];
+         out[i] = stbi__clamp((t + 8192 + (128 << 14)) >> 14);
+      }
+   }
+}
+
+static void stbi__idct_block_4x4(stbi_uc *out, int out_stride, short data[64])
+{
+   stbi__idct_scaled(out, out_stride, data, stbi__idct_table_4x4, 4);
+}
+
+static void stbi__idct_block_2x2(stbi_uc *out, int out_stride, short data[64])
+{
+   stbi__idct_scaled(out, out_stride, data, stbi__idct_table_2x2, 2);
+}
+
+static void stbi__idct_block_1x1(stbi_uc *out, int out_stride, short data[64])
+{
+   // DC only: the block average is DC/8
+   STBI_NOTUSED(out_stride);
+   out[0] = stbi__clamp(((data[0] + 4) >> 3) + 128);
+}
+
 #ifdef STBI_SSE2
 // sse2 integer IDCT. not the fastest possible implementation but it
 // produces bit-identical results to the generic C version so it's
@@ -2634,9 +2714,33 @@ static void stbi__jpeg_reset(stbi__jpeg *j)
    // since we don't even allow 1<<30 pixels
 }
 
+// skip the rest of an entropy-coded segment (including restart markers)
+// without decoding it, leaving the next real marker pending
+static int stbi__skip_entropy_coded_data(stbi__jpeg *z)
+{
+   while (!stbi__at_eof(z->s)) {
+      int x = stbi__get8(z->s);
+      if (x == 255) {
+         do {
+            x = stbi__get8(z->s);
+         } while (x == 255 && !stbi__at_eof(z->s));
+         if (x != 0 && !STBI__RESTART(x)) {
+            z->marker = (stbi_uc) x;
+            return 1;
+         }
+      }
+   }
+   return 1;
+}
+
 static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
 {
    stbi__jpeg_reset(z);
+   // a DC-only decode never reads AC coefficients, so progressive AC scans
+   // can be skipped whole. (at 1/2 and 1/4 scale a later refinement scan may
+   // span the skipped band and needs its history, so those decode everything)
+   if (z->progressive && z->spec_start != 0 && z->scale_shift == 3)
+      return stbi__skip_entropy_coded_data(z);
    if (!z->progressive) {
       if (z->scan_n == 1) {
          int i,j;
@@ -2652,7 +2756,7 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                int ha = z->img_comp[n].ha;
                if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*z->block_size+i*z->block_size, z->img_comp[n].w2, data);
                // every data block is an MCU, so countdown the restart interval
                if (--z->todo <= 0) {
                   if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
@@ -2676,8 +2780,8 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                   // by the basic H and V specified for the component
                   for (y=0; y < z->img_comp[n].v; ++y) {
                      for (x=0; x < z->img_comp[n].h; ++x) {
-                        int x2 = (i*z->img_comp[n].h + x)*8;
-                        int y2 = (j*z->img_comp[n].v + y)*8;
+                        int x2 = (i*z->img_comp[n].h + x)*z->block_size;
+                        int y2 = (j*z->img_comp[n].v + y)*z->block_size;
                         int ha = z->img_comp[n].ha;
                         if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
                         z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
@@ -2777,7 +2881,7 @@ static void stbi__jpeg_finish(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
                stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*z->block_size+i*z->block_size, z->img_comp[n].w2, data);
             }
          }
       }
@@ -2978,10 +3082,27 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       z->img_comp[i].tq = stbi__get8(s);  if (z->img_comp[i].tq > 3) return stbi__err("bad TQ","Corrupt JPEG");
    }
 
+   z->scale_shift = 0;
+   z->block_size = 8;
+
    if (scan != STBI__SCAN_load) return 1;
 
    if (!stbi__mad3sizes_valid(s->img_x, s->img_y, s->img_n, 0)) return stbi__err("too large", "Image too large to decode");
 
+   // pick the smallest reduced-IDCT scale that still covers the requested size
+   if (s->scale_min_x > 0 || s->scale_min_y > 0) {
+      while (z->scale_shift < 3) {
+         int next = z->scale_shift + 1;
+         if ((int) ((s->img_x + (1 << next) - 1) >> next) < s->scale_min_x) break;
+         if ((int) ((s->img_y + (1 << next) - 1) >> next) < s->scale_min_y) break;
+         z->scale_shift = next;
+      }
+      z->block_size = 8 >> z->scale_shift;
+      if      (z->scale_shift == 1) z->idct_block_kernel = stbi__idct_block_4x4;
+      else if (z->scale_shift == 2) z->idct_block_kernel = stbi__idct_block_2x2;
+      else if (z->scale_shift == 3) z->idct_block_kernel = stbi__idct_block_1x1;
+   }
+
    for (i=0; i < s->img_n; ++i) {
       if (z->img_comp[i].h > h_max) h_max = z->img_comp[i].h;
       if (z->img_comp[i].v > v_max) v_max = z->img_comp[i].v;
@@ -3007,8 +3128,8 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       //
       // img_mcu_x, img_mcu_y: <=17 bits; comp[i].h and .v are <=4 (checked earlier)
       // so these muls can't overflow with 32-bit ints (which we require)
-      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * 8;
-      z->img_comp[i].h2 = z->img_mcu_y * z->img_comp[i].v * 8;
+      z->img_comp[i].w2 = z->img_mcu_x * z->img_comp[i].h * z->block_size;
+      z->img_comp[i].h2 = z->img_mcu_y * z->img_comp[i].v * z->block_size;
       z->img_comp[i].coeff = 0;
       z->img_comp[i].raw_coeff = 0;
       z->img_comp[i].linebuf = NULL;
@@ -3018,16 +3139,21 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       // align blocks for idct using mmx/sse
       z->img_comp[i].data = (stbi_uc*) (((size_t) z->img_comp[i].raw_data + 15) & ~15);
       if (z->progressive) {
-         // w2, h2 are multiples of 8 (see above)
-         z->img_comp[i].coeff_w = z->img_comp[i].w2 / 8;
-         z->img_comp[i].coeff_h = z->img_comp[i].h2 / 8;
-         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].w2, z->img_comp[i].h2, sizeof(short), 15);
+         // w2, h2 are multiples of block_size (see above)
+         z->img_comp[i].coeff_w = z->img_comp[i].w2 / z->block_size;
+         z->img_comp[i].coeff_h = z->img_comp[i].h2 / z->block_size;
+         z->img_comp[i].raw_coeff = stbi__malloc_mad3(z->img_comp[i].coeff_w * 8, z->img_comp[i].coeff_h * 8, sizeof(short), 15);
          if (z->img_comp[i].raw_coeff == NULL)
             return stbi__free_jpeg_components(z, i+1, stbi__err("outofmem", "Out of memory"));
          z->img_comp[i].coeff = (short*) (((size_t) z->img_comp[i].raw_coeff + 15) & ~15);
       }
    }
 
+   // from here on the image is the decoded (possibly reduced) size; the
+   // component x,y stay at coded size since they count the 8x8 blocks
+   s->img_x = (s->img_x + (1 << z->scale_shift) - 1) >> z->scale_shift;
+   s->img_y = (s->img_y + (1 << z->scale_shift) - 1) >> z->scale_shift;
+
    return 1;
 }
 
@@ -3548,12 +3674,16 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
       unsigned int i,j;
       stbi_uc *output;
       stbi_uc *coutput[4];
+      int comp_y[4];
 
       stbi__resample res_comp[4];
 
       for (k=0; k < decode_n; ++k) {
          stbi__resample *r = &res_comp[k];
 
+         // number of decoded rows in this component
+         comp_y[k] = (z->img_comp[k].y + (1 << z->scale_shift) - 1) >> z->scale_shift;
+
          // allocate line buffer big enough for upsampling off the edges
          // with upsample factor of 4
          z->img_comp[k].linebuf = (stbi_uc *) stbi__malloc(z->s->img_x + 3);
@@ -3590,7 +3720,7 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
             if (++r->ystep >= r->vs) {
                r->ystep = 0;
                r->line0 = r->line1;
-               if (++r->ypos < z->img_comp[k].y)
+               if (++r->ypos < comp_y[k])
                   r->line1 += z->img_comp[k].w2;
             }
          }
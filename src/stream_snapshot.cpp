@@ -0,0 +1,100 @@
+static void init_stream_snapshots(StreamSnapshots *snapshots)
+{
+    snapshots->current = 0;
+    snapshots->global_epoch = 1;
+    snapshots->cycle = 0;
+    snapshots->num_readers = 0;
+    snapshots->skipped_publishes = 0;
+
+    for (u32 buffer_index = 0; buffer_index < STREAM_SNAPSHOT_BUFFERS; ++buffer_index)
+    {
+        snapshots->buffers[buffer_index].retired_epoch = 0;
+    }
+}
+
+// NOTE(dan): every reading thread registers once and keeps its index
+static u32 register_snapshot_reader(StreamSnapshots *snapshots)
+{
+    u32 reader_index = atomic_add_u32(&snapshots->num_readers, 1);
+    assert(reader_index < MAX_SNAPSHOT_READERS);
+
+    snapshots->readers[reader_index].epoch = 0;
+    return reader_index;
+}
+
+// NOTE(dan): the returned snapshot stays valid until end_snapshot_read, it may be 0
+// before the first publish. the reader's epoch has to be visible before the
+// pointer is read, so it is stored with an interlocked exchange
+static StreamSnapshot *begin_snapshot_read(StreamSnapshots *snapshots, u32 reader_index)
+{
+    SnapshotReader *reader = snapshots->readers + reader_index;
+    atomic_exchange_u64(&reader->epoch, snapshots->global_epoch);
+
+    StreamSnapshot *snapshot = (StreamSnapshot *)atomic_read_pointer((void *volatile *)&snapshots->current);
+    return snapshot;
+}
+
+static void end_snapshot_read(StreamSnapshots *snapshots, u32 reader_index)
+{
+    SnapshotReader *reader = snapshots->readers + reader_index;
+
+    complete_previous_reads_before_future_reads;
+    atomic_exchange_u64(&reader->epoch, 0);
+}
+
+// NOTE(dan): a replaced snapshot is free when every active reader entered after it was replaced
+static b32 snapshot_buffer_is_free(StreamSnapshots *snapshots, StreamSnapshot *buffer)
+{
+    b32 free = (buffer != snapshots->current);
+    if (free && buffer->retired_epoch)
+    {
+        u32 num_readers = snapshots->num_readers;
+        for (u32 reader_index = 0; reader_index < num_readers; ++reader_index)
+        {
+            u64 reader_epoch = snapshots->readers[reader_index].epoch;
+            if (reader_epoch && (reader_epoch < buffer->retired_epoch))
+            {
+                free = false;
+                break;
+            }
+        }
+    }
+    return free;
+}
+
+// NOTE(dan): writer side, only one thread publishes. returns a buffer to fill or
+// 0 when slow readers still hold every spare buffer
+static StreamSnapshot *begin_snapshot_write(StreamSnapshots *snapshots)
+{
+    StreamSnapshot *snapshot = 0;
+    for (u32 buffer_index = 0; buffer_index < STREAM_SNAPSHOT_BUFFERS; ++buffer_index)
+    {
+        StreamSnapshot *buffer = snapshots->buffers + buffer_index;
+        if (snapshot_buffer_is_free(snapshots, buffer))
+        {
+            snapshot = buffer;
+            break;
+        }
+    }
+
+    if (!snapshot)
+    {
+        ++snapshots->skipped_publishes;
+    }
+    return snapshot;
+}
+
+static void end_snapshot_write(StreamSnapshots *snapshots, StreamSnapshot *snapshot)
+{
+    snapshot->cycle = ++snapshots->cycle;
+    snapshot->retired_epoch = 0;
+
+    StreamSnapshot *replaced = (StreamSnapshot *)atomic_exchange_pointer((void *volatile *)&snapshots->current, snapshot);
+
+    // NOTE(dan): readers entering from now on can't see the replaced snapshot anymore
+    u64 epoch = atomic_add_u64(&snapshots->global_epoch, 1) + 1;
+    if (replaced)
+    {
+        replaced->retired_epoch = epoch;
+    }
+}
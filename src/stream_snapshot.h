@@ -0,0 +1,66 @@
+// NOTE(dan): readers never see the update thread's working state. every cycle the
+// update thread copies the stream states into a spare buffer and publishes it with
+// an atomic pointer swap. a replaced snapshot is reused once every reader that
+// could still hold it has left, which readers announce with a global epoch
+#define STREAM_SNAPSHOT_BUFFERS     4
+#define MAX_SNAPSHOT_READERS        8
+
+struct StreamState
+{
+    b32 online;
+    b32 not_exists_on_twitch;
+    u32 logo_hash;
+    char game[128];
+
+    // NOTE(dan): the peak and the average over the stats window
+    u32 viewers;
+    u32 peak_viewers;
+    u32 average_viewers;
+
+    // NOTE(dan): the latest finished session, 0 when there's none on record
+    u64 last_session_end;
+    u64 last_session_seconds;
+};
+
+// NOTE(dan): how the update cycles keep up with their deadlines
+struct CycleStats
+{
+    u64 cycles;
+    u64 overruns;
+    u64 missed_ticks;
+    u64 deferred_batches;
+    u64 deferred_notifications;
+
+    u32 last_duration_ms;
+    u32 max_duration_ms;
+};
+
+struct StreamSnapshot
+{
+    u64 cycle;
+    u64 retired_epoch;  // NOTE(dan): 0 while it was never published or is current
+
+    CycleStats cycle_stats;
+
+    u32 num_streams;
+    StreamState streams[MAX_STREAMS];
+};
+
+struct SnapshotReader
+{
+    u64 volatile epoch;     // NOTE(dan): 0 when not reading
+    u8 padding[56];         // NOTE(dan): one cache line per reader
+};
+
+struct StreamSnapshots
+{
+    StreamSnapshot *volatile current;
+    u64 volatile global_epoch;
+    u64 cycle;
+
+    u32 volatile num_readers;
+    SnapshotReader readers[MAX_SNAPSHOT_READERS];
+
+    u32 skipped_publishes;
+    StreamSnapshot buffers[STREAM_SNAPSHOT_BUFFERS];
+};
@@ -0,0 +1,193 @@
+// NOTE(dan): reserves a spot for a glyph, rows are filled left to right
+static b32 allocate_glyph(GlyphAtlas *atlas, u32 width, u32 height, Glyph *glyph)
+{
+    b32 allocated = false;
+
+    if (atlas->fill_x + width > GLYPH_ATLAS_WIDTH)
+    {
+        atlas->fill_x = 0;
+        atlas->fill_y += atlas->row_height + 1;
+        atlas->row_height = 0;
+    }
+
+    if ((width <= GLYPH_ATLAS_WIDTH) && (atlas->fill_y + height <= GLYPH_ATLAS_HEIGHT))
+    {
+        glyph->x = (u16)atlas->fill_x;
+        glyph->y = (u16)atlas->fill_y;
+        glyph->width = (u16)width;
+        glyph->height = (u16)height;
+
+        atlas->fill_x += width + 1;
+        if (atlas->row_height < height)
+        {
+            atlas->row_height = height;
+        }
+        allocated = true;
+    }
+
+    return allocated;
+}
+
+inline Glyph *get_glyph(Font *font, char c)
+{
+    Glyph *glyph = 0;
+    if ((c >= FIRST_GLYPH) && (c <= LAST_GLYPH))
+    {
+        glyph = font->glyphs + (c - FIRST_GLYPH);
+    }
+    return glyph;
+}
+
+static u32 hash_text(FontId font_id, char *text)
+{
+    // NOTE(dan): FNV-1a
+    u32 hash = 2166136261 ^ (u32)font_id;
+    for (char *at = text; *at; ++at)
+    {
+        hash ^= (u8)*at;
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+static void layout_text(GlyphAtlas *atlas, FontId font_id, char *text, TextLayout *layout)
+{
+    Font *font = atlas->fonts + font_id;
+
+    layout->font_id = font_id;
+    layout->num_glyphs = 0;
+
+    i32 pen_x = 0;
+    for (char *at = text; *at && (layout->num_glyphs < TEXT_LAYOUT_MAX_GLYPHS); ++at)
+    {
+        Glyph *glyph = get_glyph(font, *at);
+        if (!glyph)
+        {
+            glyph = get_glyph(font, '?');
+        }
+
+        // NOTE(dan): blank glyphs only move the pen
+        if (glyph->width && glyph->height)
+        {
+            LaidOutGlyph *laid_out = layout->glyphs + layout->num_glyphs++;
+            laid_out->x = (i16)(pen_x + glyph->offset_x);
+            laid_out->y = (i16)(font->ascent - glyph->offset_y);
+            laid_out->glyph_index = (u16)(glyph - font->glyphs);
+        }
+
+        pen_x += glyph->advance;
+    }
+
+    layout->width = pen_x;
+}
+
+static TextLayout *get_text_layout(GlyphAtlas *atlas, FontId font_id, char *text)
+{
+    TextLayoutCache *cache = &atlas->layout_cache;
+    TextLayout *layout = 0;
+
+    if (string_length(text) < TEXT_LAYOUT_MAX_TEXT)
+    {
+        u32 hash = hash_text(font_id, text);
+        TextLayout *set = cache->layouts[hash % TEXT_LAYOUT_CACHE_SETS];
+
+        for (u32 way_index = 0; way_index < TEXT_LAYOUT_CACHE_WAYS; ++way_index)
+        {
+            TextLayout *test_layout = set + way_index;
+            if (test_layout->used && (test_layout->hash == hash) &&
+                (test_layout->font_id == font_id) && strings_equal(test_layout->text, text))
+            {
+                layout = test_layout;
+                break;
+            }
+        }
+
+        if (layout)
+        {
+            ++cache->hits;
+        }
+        else
+        {
+            ++cache->misses;
+
+            // NOTE(dan): least recently used way of the set
+            layout = set;
+            for (u32 way_index = 0; way_index < TEXT_LAYOUT_CACHE_WAYS; ++way_index)
+            {
+                TextLayout *test_layout = set + way_index;
+                if (!test_layout->used)
+                {
+                    layout = test_layout;
+                    break;
+                }
+                if (test_layout->last_used < layout->last_used)
+                {
+                    layout = test_layout;
+                }
+            }
+
+            layout_text(atlas, font_id, text, layout);
+            layout->used = true;
+            layout->hash = hash;
+            copy_string(text, layout->text);
+        }
+
+        layout->last_used = ++cache->use_clock;
+    }
+    else
+    {
+        layout = &cache->scratch;
+        layout_text(atlas, font_id, text, layout);
+    }
+
+    return layout;
+}
+
+// NOTE(dan): clipped at max_x like DT_SINGLELINE. x, y is the top-left of the line
+static void draw_text_layout(Bitmap *bitmap, GlyphAtlas *atlas, TextLayout *layout, i32 x, i32 y, i32 max_x, u32 color)
+{
+    Font *font = atlas->fonts + layout->font_id;
+
+    if (max_x > bitmap->width)
+    {
+        max_x = bitmap->width;
+    }
+
+    for (u32 glyph_index = 0; glyph_index < layout->num_glyphs; ++glyph_index)
+    {
+        LaidOutGlyph *laid_out = layout->glyphs + glyph_index;
+        Glyph *glyph = font->glyphs + laid_out->glyph_index;
+
+        i32 min_x = x + laid_out->x;
+        i32 min_y = y + laid_out->y;
+        if (min_x >= max_x)
+        {
+            break;
+        }
+
+        i32 glyph_max_x = min_x + glyph->width;
+        i32 glyph_max_y = min_y + glyph->height;
+
+        i32 clip_min_x = (min_x < 0) ? 0 : min_x;
+        i32 clip_min_y = (min_y < 0) ? 0 : min_y;
+        i32 clip_max_x = (glyph_max_x > max_x) ? max_x : glyph_max_x;
+        i32 clip_max_y = (glyph_max_y > bitmap->height) ? bitmap->height : glyph_max_y;
+
+        if (clip_min_x < clip_max_x)
+        {
+            for (i32 dest_y = clip_min_y; dest_y < clip_max_y; ++dest_y)
+            {
+                u8 *coverage = atlas->coverage + (glyph->y + dest_y - min_y) * GLYPH_ATLAS_WIDTH + glyph->x + (clip_min_x - min_x);
+                u32 *dest_pixel = get_pixel_pointer(bitmap, clip_min_x, dest_y);
+
+                render_kernels.blend_coverage_row(dest_pixel, coverage, clip_max_x - clip_min_x, color);
+            }
+        }
+    }
+}
+
+static void draw_text(Bitmap *bitmap, GlyphAtlas *atlas, FontId font_id, char *text, i32 x, i32 y, i32 max_x, u32 color)
+{
+    TextLayout *layout = get_text_layout(atlas, font_id, text);
+    draw_text_layout(bitmap, atlas, layout, x, y, max_x, color);
+}
@@ -0,0 +1,86 @@
+// NOTE(dan): glyphs are rasterized once by the platform layer into an 8-bit
+// coverage atlas, text is drawn from the atlas without any OS calls
+#define GLYPH_ATLAS_WIDTH   512
+#define GLYPH_ATLAS_HEIGHT  256
+#define FIRST_GLYPH         ' '
+#define LAST_GLYPH          '~'
+#define GLYPH_COUNT         (LAST_GLYPH - FIRST_GLYPH + 1)
+
+struct Glyph
+{
+    u16 x;
+    u16 y;
+    u16 width;
+    u16 height;
+    i16 offset_x;   // NOTE(dan): from the pen position to the left edge
+    i16 offset_y;   // NOTE(dan): from the baseline up to the top edge
+    i16 advance;
+};
+
+struct Font
+{
+    i32 height;
+    i32 ascent;
+    Glyph glyphs[GLYPH_COUNT];
+};
+
+enum FontId
+{
+    FontId_Header,
+    FontId_Message,
+
+    FontId_Count,
+};
+
+// NOTE(dan): laid out lines are cached by string, headers and game names repeat
+// all the time, so drawing them is a hash lookup and a run of glyph blits
+#define TEXT_LAYOUT_MAX_TEXT        256
+#define TEXT_LAYOUT_MAX_GLYPHS      128
+#define TEXT_LAYOUT_CACHE_SETS      16
+#define TEXT_LAYOUT_CACHE_WAYS      4
+
+struct LaidOutGlyph
+{
+    i16 x;          // NOTE(dan): from the line origin to the left edge
+    i16 y;          // NOTE(dan): from the top of the line to the top edge
+    u16 glyph_index;
+};
+
+struct TextLayout
+{
+    b32 used;
+    u32 hash;
+    FontId font_id;
+    u64 last_used;
+
+    i32 width;
+    u32 num_glyphs;
+    LaidOutGlyph glyphs[TEXT_LAYOUT_MAX_GLYPHS];
+
+    char text[TEXT_LAYOUT_MAX_TEXT];
+};
+
+struct TextLayoutCache
+{
+    u64 use_clock;
+    u32 hits;
+    u32 misses;
+
+    // NOTE(dan): for strings too long to be cached
+    TextLayout scratch;
+
+    TextLayout layouts[TEXT_LAYOUT_CACHE_SETS][TEXT_LAYOUT_CACHE_WAYS];
+};
+
+struct GlyphAtlas
+{
+    u32 fill_x;
+    u32 fill_y;
+    u32 row_height;
+
+    Font fonts[FontId_Count];
+    u8 coverage[GLYPH_ATLAS_WIDTH * GLYPH_ATLAS_HEIGHT];
+
+    // NOTE(dan): layouts depend on the baked metrics, so they live with the atlas
+    TextLayoutCache layout_cache;
+};
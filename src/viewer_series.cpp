@@ -0,0 +1,165 @@
+inline u32 encode_varint(u8 *out, u64 value)
+{
+    u32 size = 0;
+    while (value >= 0x80)
+    {
+        out[size++] = (u8)(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = (u8)value;
+    return size;
+}
+
+inline u64 decode_varint(u8 **at)
+{
+    u64 value = 0;
+    u32 shift = 0;
+    for (;;)
+    {
+        u8 byte = *(*at)++;
+        value |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            break;
+        }
+        shift += 7;
+    }
+    return value;
+}
+
+inline u64 zigzag_encode(i64 value)
+{
+    u64 result = ((u64)value << 1) ^ (u64)(value >> 63);
+    return result;
+}
+
+inline i64 zigzag_decode(u64 value)
+{
+    i64 result = (i64)(value >> 1) ^ -(i64)(value & 1);
+    return result;
+}
+
+static void begin_viewer_block(ViewerSeries *series, u64 time, u32 viewers)
+{
+    u32 block_index;
+    if (series->num_blocks < VIEWER_BLOCKS_PER_STREAM)
+    {
+        block_index = (series->first_block + series->num_blocks++) % VIEWER_BLOCKS_PER_STREAM;
+    }
+    else
+    {
+        block_index = series->first_block;
+        series->first_block = (series->first_block + 1) % VIEWER_BLOCKS_PER_STREAM;
+    }
+
+    ViewerBlock *block = series->blocks + block_index;
+    block->first_time = time;
+    block->last_time = time;
+    block->sum_viewers = viewers;
+    block->first_viewers = viewers;
+    block->last_viewers = viewers;
+    block->max_viewers = viewers;
+    block->last_delta = 0;
+    block->num_samples = 1;
+    block->used = 0;
+}
+
+// NOTE(dan): samples have to come in time order, one from the same second or earlier is dropped
+static void append_viewer_sample(ViewerSeries *series, u64 time, u32 viewers)
+{
+    ViewerBlock *block = 0;
+    if (series->num_blocks)
+    {
+        block = series->blocks + (series->first_block + series->num_blocks - 1) % VIEWER_BLOCKS_PER_STREAM;
+    }
+
+    if (!block)
+    {
+        begin_viewer_block(series, time, viewers);
+    }
+    else if (time > block->last_time)
+    {
+        u8 encoded[VIEWER_MAX_SAMPLE_SIZE];
+        u64 delta = time - block->last_time;
+        u32 size = encode_varint(encoded, zigzag_encode((i64)delta - (i64)block->last_delta));
+        size += encode_varint(encoded + size, zigzag_encode((i64)viewers - (i64)block->last_viewers));
+
+        if (delta <= 0xFFFFFFFF && block->used + size <= VIEWER_BLOCK_DATA_SIZE)
+        {
+            copy_memory(block->data + block->used, encoded, size);
+            block->used += size;
+
+            block->last_time = time;
+            block->last_delta = (u32)delta;
+            block->last_viewers = viewers;
+            block->sum_viewers += viewers;
+            if (viewers > block->max_viewers)
+            {
+                block->max_viewers = viewers;
+            }
+            ++block->num_samples;
+        }
+        else
+        {
+            begin_viewer_block(series, time, viewers);
+        }
+    }
+}
+
+// NOTE(dan): the samples from from to to, both inclusive
+static ViewerStats get_viewer_stats(ViewerSeries *series, u64 from, u64 to)
+{
+    ViewerStats stats = {};
+
+    for (u32 block_offset = 0; block_offset < series->num_blocks; ++block_offset)
+    {
+        ViewerBlock *block = series->blocks + (series->first_block + block_offset) % VIEWER_BLOCKS_PER_STREAM;
+        if (block->last_time < from || block->first_time > to)
+        {
+            continue;
+        }
+
+        if (block->first_time >= from && block->last_time <= to)
+        {
+            stats.num_samples += block->num_samples;
+            stats.sum_viewers += block->sum_viewers;
+            if (block->max_viewers > stats.peak_viewers)
+            {
+                stats.peak_viewers = block->max_viewers;
+            }
+        }
+        else
+        {
+            u64 time = block->first_time;
+            u32 viewers = block->first_viewers;
+            i64 delta = 0;
+
+            u8 *at = block->data;
+            for (u32 sample_index = 0; sample_index < block->num_samples; ++sample_index)
+            {
+                if (sample_index)
+                {
+                    delta += zigzag_decode(decode_varint(&at));
+                    time += delta;
+                    viewers = (u32)((i64)viewers + zigzag_decode(decode_varint(&at)));
+                }
+
+                if (time > to)
+                {
+                    break;
+                }
+
+                if (time >= from)
+                {
+                    ++stats.num_samples;
+                    stats.sum_viewers += viewers;
+                    if (viewers > stats.peak_viewers)
+                    {
+                        stats.peak_viewers = viewers;
+                    }
+                }
+            }
+        }
+    }
+    return stats;
+}
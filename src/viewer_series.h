@@ -0,0 +1,39 @@
+// NOTE(dan): the viewer counts of a channel, sampled whenever it's polled while live.
+// samples are packed into fixed-size blocks: the first one of a block is kept as
+// is, the rest as zigzag varints of the delta of the time delta and of the viewer
+// delta. with polls on a fixed interval that's usually one byte for the time and
+// one or two for the viewers. every block also keeps the peak and the sum of its
+// samples, so a range query only decodes the blocks the range cuts through.
+// the blocks of a channel are a ring, the oldest one is reused when it's full
+#define VIEWER_BLOCK_DATA_SIZE      256
+#define VIEWER_BLOCKS_PER_STREAM    64
+#define VIEWER_MAX_SAMPLE_SIZE      15  // NOTE(dan): a 10 byte varint for the time, 5 for the viewers
+
+struct ViewerBlock
+{
+    u64 first_time;     // NOTE(dan): unix seconds
+    u64 last_time;
+    u64 sum_viewers;
+    u32 first_viewers;
+    u32 last_viewers;
+    u32 max_viewers;
+    u32 last_delta;     // NOTE(dan): seconds between the last two samples
+
+    u32 num_samples;
+    u32 used;           // NOTE(dan): bytes of data
+    u8 data[VIEWER_BLOCK_DATA_SIZE];
+};
+
+struct ViewerSeries
+{
+    u32 first_block;
+    u32 num_blocks;
+    ViewerBlock blocks[VIEWER_BLOCKS_PER_STREAM];
+};
+
+struct ViewerStats
+{
+    u32 num_samples;
+    u32 peak_viewers;
+    u64 sum_viewers;
+};
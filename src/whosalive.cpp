@@ -1,24 +1,183 @@
 #include "json.h"
+#include "logo_cache.h"
+#include "render.h"
+#include "text.h"
+#include "card.h"
+#include "animation.h"
+#include "events.h"
+#include "stream_snapshot.h"
+#include "poll_scheduler.h"
+#include "poll_model.h"
+#include "request_budget.h"
+#include "session_history.h"
+#include "viewer_series.h"
 
 #include "json.cpp"
+#include "render.cpp"
+#include "text.cpp"
+#include "card.cpp"
+#include "animation.cpp"
+#include "events.cpp"
+#include "stream_snapshot.cpp"
+#include "poll_scheduler.cpp"
+#include "poll_model.cpp"
+#include "request_budget.cpp"
+#include "session_history.cpp"
+#include "viewer_series.cpp"
+#include "logo_cache.cpp"
+
+#define POLL_DEFAULT_INTERVAL_SECS  60
+#define POLL_BATCH_MAX_CHANNELS     100 // NOTE(dan): most channels one streams request takes
+#define POLL_RETRY_BASE_SECS        2
+#define POLL_RETRY_MAX_SECS         300
+#define UPDATE_CYCLE_BUDGET_DIVISOR 4   // NOTE(dan): a cycle gets a quarter of the poll interval
+#define RESPONSE_MAX_TOKENS         (POLL_BATCH_MAX_CHANNELS * 128) // NOTE(dan): a live stream is ~80 tokens
+#define FINGERPRINT_TABLE_SIZE      256 // NOTE(dan): has to be a power of two, at least twice the batch size
+#define VIEWER_STATS_WINDOW_SECS    (24 * 60 * 60)
+#define STREAM_STATE_FILE_MAGIC     0x53535757 // NOTE(dan): "WWSS"
+#define STREAM_STATE_FILE_VERSION   2 // NOTE(dan): 2 keeps the start of the open session
+#define STREAM_STATE_MAX_AGE_SECS   (30 * 60) // NOTE(dan): older than that, a live channel is taken for a new stream
 
 struct Stream
 {
     u32 logo_hash;
+    u32 poll_interval;
 
     char channel_id[128];
 
     char name[128];
     char game[128];
+    char title[256];
+    char logo_url[512];
 
     b32 online;
     b32 was_online;
 
     b32 not_exists_on_twitch;
+
+    // NOTE(dan): a go-live is put halfway between the last two successful polls,
+    // the first poll after startup only tells what's already live
+    b32 polled;
+    u64 last_poll_wall_seconds;
+    PollModel poll_model;
+
+    // NOTE(dan): failed polls in a row, the channel is retried with backoff meanwhile
+    u32 poll_failures;
+
+    // NOTE(dan): set while the go-live logo is downloading on the work queue
+    u32 volatile logo_pending;
+
+    // NOTE(dan): of the stream object in the last response, 0 while offline
+    u64 fingerprint;
+    u32 viewers;
+
+    // NOTE(dan): what the UI thread was told, a change that didn't fit in the
+    // event queue is published again in the next cycle
+    b32 published_online;
+    char published_game[128];
+    char published_title[256];
+    b32 notification_pending;
+    Notification notification;
 };
 
 static u32 num_streams;
-static Stream streams[64];
+static Stream streams[MAX_STREAMS];
+static ViewerSeries viewer_series[MAX_STREAMS];
+
+// NOTE(dan): go-live notifications collected by the UI thread until the end of the cycle
+struct PendingNotifications
+{
+    u32 count;
+    Notification notifications[MAX_STREAMS];
+};
+
+static TransitionLog transition_log;
+static u32 ui_transition_consumer;
+static SessionHistory session_history;
+static PendingNotifications pending_notifications;
+static StreamSnapshots stream_snapshots;
+
+// NOTE(dan): the channels of one streams request
+struct PollBatch
+{
+    u32 count;
+    u32 stream_indices[POLL_BATCH_MAX_CHANNELS];
+};
+
+// NOTE(dan): every cycle has a budget taken from the poll interval, the tick only says
+// how often the scheduler is looked at. what doesn't fit in the budget, the rest of
+// the due channels or go-lives still waiting for their logo, is left for the next cycle
+struct UpdateCycle
+{
+    f64 start;
+    f64 deadline;
+    u64 time;   // NOTE(dan): unix seconds when it started
+};
+
+static CycleStats cycle_stats;
+static b32 stream_changes_pending;
+static b32 users_resolved;      // NOTE(dan): the users query went through, channels without an id don't exist
+static b32 cycle_end_pending;   // NOTE(dan): a cycle's events went out but its CycleEnd didn't fit
+
+static PollScheduler poll_scheduler;
+static PollTimer poll_timers[MAX_STREAMS];
+
+struct PollModelFile
+{
+    PollModelFileHeader header;
+    PollModelFileEntry entries[MAX_STREAMS];
+};
+
+static b32 poll_models_changed;
+static PollModelFile poll_model_file;
+
+// NOTE(dan): what the channels were doing when the last cycle ended, so that a
+// restart doesn't announce every channel that's already live
+struct StreamStateFileHeader
+{
+    u32 magic;
+    u32 version;
+    u32 num_entries;
+    u32 padding;
+    u64 saved_time;     // NOTE(dan): unix seconds
+};
+
+struct StreamStateFileEntry
+{
+    u32 name_hash;
+    b32 online;
+    u32 logo_hash;
+    u64 session_start;  // NOTE(dan): unix seconds, of the session history's open session
+    char game[128];
+    char title[256];
+};
+
+struct StreamStateFile
+{
+    StreamStateFileHeader header;
+    StreamStateFileEntry entries[MAX_STREAMS];
+};
+
+static StreamStateFile stream_state_file;
+
+static u32 poll_random_state;
+
+// NOTE(dan): the users query is done before the update thread starts, after that
+// only the update thread parses responses
+static JsonToken response_tokens[RESPONSE_MAX_TOKENS];
+
+struct Settings
+{
+    u32 logo_cache_max_kb;
+    u32 logo_cache_max_entries;
+
+    b32 logo_warmup;
+    u32 logo_warmup_threads;
+
+    u32 poll_interval_secs;
+};
+
+static Settings settings;
 
 inline Stream *get_stream_by_name(char *name)
 {
@@ -45,122 +204,477 @@ static u32 djb2_hash(char *string)
     return hash;
 }
 
-static void notify_or_update_online_stream(char *name, char *game, char *display_name, char *logo_url)
+// NOTE(dan): multiply-rotate over eight bytes at a time with a murmur finalizer,
+// only has to tell apart two versions of the same stream object
+static u64 hash_bytes_64(char *data, u32 size, u64 seed)
+{
+    u64 hash = seed ^ (size * 0x9E3779B97F4A7C15ULL);
+
+    char *at = data;
+    for ( ; size >= 8; size -= 8, at += 8)
+    {
+        hash ^= *(u64 *)at * 0x87C37B91114253D5ULL;
+        hash = ((hash << 27) | (hash >> 37)) * 0x4CF5AD432745937FULL + 0x52DCE729;
+    }
+
+    u64 tail = 0;
+    for (u32 byte_index = 0; byte_index < size; ++byte_index)
+    {
+        tail |= (u64)(u8)at[byte_index] << (byte_index*8);
+    }
+    hash ^= tail * 0x87C37B91114253D5ULL;
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// NOTE(dan): over the strings of a stream object only, numbers like the viewer and
+// follower counts change on every poll. the viewer count is read on its own.
+// tokens are in document order, so the object's tokens are the ones inside its span
+static u64 get_stream_object_fingerprint(JsonParser *parser, char *json_string, JsonToken *object)
+{
+    u64 fingerprint = 0;
+
+    JsonToken *one_past_last = parser->token_array + parser->num_tokens;
+    for (JsonToken *token = object + 1; token < one_past_last && token->start < object->end; ++token)
+    {
+        if (token->type == JsonType_String)
+        {
+            fingerprint = hash_bytes_64(json_string + token->start, token->end - token->start, fingerprint);
+        }
+    }
+    return fingerprint ? fingerprint : 1;
+}
+
+static u32 get_stream_object_viewers(JsonParser *parser, char *json_string, JsonToken *object)
+{
+    u32 viewers = 0;
+    for (JsonIterator iterator = json_iterator_get(parser, object); json_iterator_valid(iterator); iterator = json_iterator_next(iterator))
+    {
+        JsonToken *identifier = json_get_token(iterator);
+        JsonToken *value = json_peek_next_token(iterator);
+
+        if (value && value->type == JsonType_Primitive && json_string_token_equals(json_string, identifier, "viewers"))
+        {
+            for (i32 char_index = value->start; char_index < value->end; ++char_index)
+            {
+                char c = json_string[char_index];
+                if (c < '0' || c > '9')
+                {
+                    break;
+                }
+                viewers = viewers*10 + (c - '0');
+            }
+            break;
+        }
+    }
+    return viewers;
+}
+
+struct FingerprintTableEntry
+{
+    u64 fingerprint;
+    u32 stream_index;
+};
+
+static PLATFORM_WORK_QUEUE_CALLBACK(do_cache_logo_work)
+{
+    Stream *stream = (Stream *)data;
+    platform.cache_logo(stream->logo_url, stream->logo_hash);
+
+    complete_previous_writes_before_future_writes;
+    stream->logo_pending = false;
+}
+
+static Stream *notify_or_update_online_stream(char *name, char *game, char *title, char *display_name, char *logo_url)
 {
     Stream *stream = get_stream_by_name(name);
     if (stream)
     {
         stream->online = true;
-        if (!stream->was_online)
+
+        u32 game_length = string_length(game);
+        if (game_length >= array_count(stream->game))
         {
-            char title[64];
-            wsprintf(title, "%s started streaming", display_name);
+            game_length = array_count(stream->game) - 1;
+        }
+        copy_string_and_null_terminate(game, stream->game, game_length);
 
-            char message[256];
-            wsprintf(message, "Playing: %s", game);
+        u32 title_length = string_length(title);
+        if (title_length >= array_count(stream->title))
+        {
+            title_length = array_count(stream->title) - 1;
+        }
+        copy_string_and_null_terminate(title, stream->title, title_length);
 
-            stream->logo_hash = djb2_hash(logo_url);
-            platform.cache_logo(logo_url, stream->logo_hash);
+        if (!stream->was_online)
+        {
+            // NOTE(dan): the logos of a burst download in parallel, post_update_streams waits for them
+            if (string_length(logo_url) < array_count(stream->logo_url))
+            {
+                copy_string(logo_url, stream->logo_url);
+            }
+            stream->logo_hash = djb2_hash(stream->logo_url);
+            stream->logo_pending = true;
+            platform.add_work(platform.high_priority_queue, do_cache_logo_work, stream);
 
-            platform.show_notification(title, message, stream->logo_hash);
+            Notification *notification = &stream->notification;
+            snprintf(notification->title, array_count(notification->title), "%s started streaming", display_name);
+            snprintf(notification->message, array_count(notification->message), "Playing: %s", game);
+            notification->logo_hash = stream->logo_hash;
+            stream->notification_pending = true;
         }
     }
+    return stream;
 }
 
-static void pre_update_streams()
+// NOTE(dan): runs on the thread that owns streams[]. when every spare buffer is still
+// being read the publish is skipped, the next cycle publishes the newer state anyway
+// NOTE(dan): time is when the viewer stats window ends
+static void publish_stream_snapshot(u64 time)
 {
-    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    StreamSnapshot *snapshot = begin_snapshot_write(&stream_snapshots);
+    if (snapshot)
     {
-        Stream *stream = streams + stream_index;
-        stream->online = false;
+        snapshot->num_streams = num_streams;
+        for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+        {
+            Stream *stream = streams + stream_index;
+            StreamState *state = snapshot->streams + stream_index;
+
+            state->online = stream->online;
+            state->not_exists_on_twitch = stream->not_exists_on_twitch;
+            state->logo_hash = stream->logo_hash;
+            copy_string(stream->game, state->game);
+
+            u64 window_start = (time > VIEWER_STATS_WINDOW_SECS) ? time - VIEWER_STATS_WINDOW_SECS : 0;
+            ViewerStats viewer_stats = get_viewer_stats(viewer_series + stream_index, window_start, time);
+            state->viewers = stream->viewers;
+            state->peak_viewers = viewer_stats.peak_viewers;
+            state->average_viewers = viewer_stats.num_samples ? (u32)(viewer_stats.sum_viewers / viewer_stats.num_samples) : 0;
+
+            FinishedSession *last_session = session_history.last_sessions + stream_index;
+            state->last_session_end = last_session->end;
+            state->last_session_seconds = last_session->end - last_session->start;
+        }
+        snapshot->cycle_stats = cycle_stats;
+        end_snapshot_write(&stream_snapshots, snapshot);
     }
 }
 
-static void post_update_streams()
+inline void fill_transition_event(TransitionEvent *event, TransitionEventType type, u32 stream_index, u64 time)
 {
+    Stream *stream = streams + stream_index;
+
+    event->type = type;
+    event->stream_index = stream_index;
+    event->time = time;
+    copy_string(stream->game, event->game);
+    copy_string(stream->title, event->title);
+    event->has_notification = false;
+}
+
+// NOTE(dan): runs on the update thread. diffs every stream against what was last
+// logged for it and logs the transitions. whatever doesn't fit in the log yet sets
+// stream_changes_pending and is logged in a later cycle
+static void post_update_streams(UpdateCycle *cycle)
+{
+    // NOTE(dan): notifications go out with their logos, the ones that aren't there by
+    // the deadline are waited for in the next cycle instead
+    platform.complete_work_before(platform.high_priority_queue, cycle->deadline);
+
+    publish_stream_snapshot(cycle->time);
+
+    b32 published = false;
+    stream_changes_pending = false;
     for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
     {
         Stream *stream = streams + stream_index;
         stream->was_online = stream->online;
+
+        TransitionEvent event;
+        if (stream->online != stream->published_online)
+        {
+            if (stream->online && stream->notification_pending && stream->logo_pending)
+            {
+                ++cycle_stats.deferred_notifications;
+                stream_changes_pending = true;
+                continue;
+            }
+
+            fill_transition_event(&event, stream->online ? TransitionEventType_WentOnline : TransitionEventType_WentOffline, stream_index, cycle->time);
+            event.has_notification = stream->online && stream->notification_pending;
+            if (event.has_notification)
+            {
+                event.notification = stream->notification;
+            }
+
+            if (push_transition_event(&transition_log, &event))
+            {
+                stream->published_online = stream->online;
+                stream->notification_pending = false;
+                copy_string(stream->game, stream->published_game);
+                copy_string(stream->title, stream->published_title);
+                published = true;
+            }
+            else
+            {
+                stream_changes_pending = true;
+            }
+        }
+        else if (stream->online)
+        {
+            if (!strings_equal(stream->game, stream->published_game))
+            {
+                fill_transition_event(&event, TransitionEventType_GameChanged, stream_index, cycle->time);
+                if (push_transition_event(&transition_log, &event))
+                {
+                    copy_string(stream->game, stream->published_game);
+                    published = true;
+                }
+                else
+                {
+                    stream_changes_pending = true;
+                }
+            }
+
+            if (!strings_equal(stream->title, stream->published_title))
+            {
+                fill_transition_event(&event, TransitionEventType_TitleChanged, stream_index, cycle->time);
+                if (push_transition_event(&transition_log, &event))
+                {
+                    copy_string(stream->title, stream->published_title);
+                    published = true;
+                }
+                else
+                {
+                    stream_changes_pending = true;
+                }
+            }
+        }
+    }
+
+    if (published || cycle_end_pending)
+    {
+        TransitionEvent event = {};
+        event.type = TransitionEventType_CycleEnd;
+        event.time = cycle->time;
+        cycle_end_pending = !push_transition_event(&transition_log, &event);
+        if (cycle_end_pending)
+        {
+            // NOTE(dan): without it the notifications aren't shown and the history isn't flushed
+            stream_changes_pending = true;
+        }
+
+        if (request_transition_wake(&transition_log, ui_transition_consumer))
+        {
+            platform.signal_events();
+        }
+    }
+}
+
+// NOTE(dan): runs on the UI thread, its own consumer of the transition log. the
+// go-live events of a cycle are shown together, as one stack of cards
+static void process_stream_events()
+{
+    begin_transition_drain(&transition_log, ui_transition_consumer);
+
+    PendingNotifications *pending = &pending_notifications;
+    TransitionEvent event;
+    while (pop_transition_event(&transition_log, ui_transition_consumer, &event))
+    {
+        switch (event.type)
+        {
+            case TransitionEventType_WentOnline:
+            {
+                if (event.has_notification && (pending->count < array_count(pending->notifications)))
+                {
+                    pending->notifications[pending->count++] = event.notification;
+                }
+            } break;
+
+            case TransitionEventType_CycleEnd:
+            {
+                if (pending->count)
+                {
+                    platform.show_notifications(pending->notifications, pending->count);
+                    pending->count = 0;
+                }
+            } break;
+
+            default:
+            {
+            } break;
+        }
     }
 }
 
-static void update_streams(void *data, u32 data_size)
+// NOTE(dan): a response that is cut off or has no streams array changes nothing and
+// returns false. otherwise the batch's channels that aren't in it are offline
+static b32 update_streams(PollBatch *batch, void *data, u32 data_size)
 {
+    b32 valid = false;
+
     char *json_string = (char *)data;
-    JsonToken tokens[1024] = {};
     JsonParser parser;
 
-    json_init_parser(&parser, tokens, array_count(tokens));
+    json_init_parser(&parser, response_tokens, array_count(response_tokens));
     json_parse(&parser, (char *)data, data_size);
 
-    for (JsonIterator root_iterator = json_iterator_get(&parser, 0); json_iterator_valid(root_iterator); root_iterator = json_iterator_next(root_iterator))
+    JsonToken *streams_array = 0;
+    if (parser.status == JsonParserStatus_Success)
     {
-        JsonToken *identifier = json_get_token(root_iterator);
-        JsonToken *value = json_peek_next_token(root_iterator);
-        
-        if (value && value->type == JsonType_Array && json_string_token_equals(json_string, identifier, "streams"))
+        for (JsonIterator root_iterator = json_iterator_get(&parser, 0); json_iterator_valid(root_iterator); root_iterator = json_iterator_next(root_iterator))
         {
-            for (JsonIterator streams_iterator = json_iterator_get(&parser, value); json_iterator_valid(streams_iterator); streams_iterator = json_iterator_next(streams_iterator))
+            JsonToken *identifier = json_get_token(root_iterator);
+            JsonToken *value = json_peek_next_token(root_iterator);
+
+            if (value && value->type == JsonType_Array && json_string_token_equals(json_string, identifier, "streams"))
             {
-                JsonToken *stream = json_get_token(streams_iterator);
-                char name[256];
-                char game[256];
-                char logo[512];
-                char display_name[256];
+                streams_array = value;
+                break;
+            }
+        }
+    }
 
-                name[0] = 0;
-                game[0] = 0;
-                logo[0] = 0;
-                display_name[0] = 0;
+    if (streams_array)
+    {
+        valid = true;
+
+        // NOTE(dan): live channels whose stream object is the same as last time are
+        // only marked online, nothing is extracted or copied for them
+        FingerprintTableEntry fingerprints[FINGERPRINT_TABLE_SIZE] = {};
+        for (u32 batch_index = 0; batch_index < batch->count; ++batch_index)
+        {
+            u32 stream_index = batch->stream_indices[batch_index];
+            Stream *stream = streams + stream_index;
+            stream->online = false;
 
-                for (JsonIterator stream_iterator = json_iterator_get(&parser, stream); json_iterator_valid(stream_iterator); stream_iterator = json_iterator_next(stream_iterator))
+            if (stream->fingerprint)
+            {
+                u32 slot = (u32)stream->fingerprint & (FINGERPRINT_TABLE_SIZE - 1);
+                while (fingerprints[slot].fingerprint)
                 {
-                    JsonToken *ident = json_get_token(stream_iterator);
-                    JsonToken *val = json_peek_next_token(stream_iterator);
+                    slot = (slot + 1) & (FINGERPRINT_TABLE_SIZE - 1);
+                }
+                fingerprints[slot].fingerprint = stream->fingerprint;
+                fingerprints[slot].stream_index = stream_index;
+            }
+        }
 
-                    if (val && val->type == JsonType_String && json_string_token_equals(json_string, ident, "game"))
-                    {
-                        char *game_src = json_string + val->start;
-                        i32 game_length = val->end - val->start;
-                        copy_string_and_null_terminate(game_src, game, game_length);
-                    }
-                    else if (val && val->type == JsonType_Object && json_string_token_equals(json_string, ident, "channel"))
+        for (JsonIterator streams_iterator = json_iterator_get(&parser, streams_array); json_iterator_valid(streams_iterator); streams_iterator = json_iterator_next(streams_iterator))
+        {
+            JsonToken *stream = json_get_token(streams_iterator);
+
+            u64 fingerprint = get_stream_object_fingerprint(&parser, json_string, stream);
+            u32 viewers = get_stream_object_viewers(&parser, json_string, stream);
+            b32 unchanged = false;
+            for (u32 slot = (u32)fingerprint & (FINGERPRINT_TABLE_SIZE - 1);
+                 fingerprints[slot].fingerprint;
+                 slot = (slot + 1) & (FINGERPRINT_TABLE_SIZE - 1))
+            {
+                if (fingerprints[slot].fingerprint == fingerprint)
+                {
+                    streams[fingerprints[slot].stream_index].online = true;
+                    streams[fingerprints[slot].stream_index].viewers = viewers;
+                    unchanged = true;
+                    break;
+                }
+            }
+
+            if (unchanged)
+            {
+                continue;
+            }
+
+            char name[256];
+            char game[256];
+            char title[512];
+            char logo[512];
+            char display_name[256];
+
+            name[0] = 0;
+            game[0] = 0;
+            title[0] = 0;
+            logo[0] = 0;
+            display_name[0] = 0;
+
+            for (JsonIterator stream_iterator = json_iterator_get(&parser, stream); json_iterator_valid(stream_iterator); stream_iterator = json_iterator_next(stream_iterator))
+            {
+                JsonToken *ident = json_get_token(stream_iterator);
+                JsonToken *val = json_peek_next_token(stream_iterator);
+
+                if (val && val->type == JsonType_String && json_string_token_equals(json_string, ident, "game"))
+                {
+                    char *game_src = json_string + val->start;
+                    i32 game_length = val->end - val->start;
+                    copy_string_and_null_terminate(game_src, game, game_length);
+                }
+                else if (val && val->type == JsonType_Object && json_string_token_equals(json_string, ident, "channel"))
+                {
+                    for (JsonIterator channel_iterator = json_iterator_get(&parser, val); json_iterator_valid(channel_iterator); channel_iterator = json_iterator_next(channel_iterator))
                     {
-                        for (JsonIterator channel_iterator = json_iterator_get(&parser, val); json_iterator_valid(channel_iterator); channel_iterator = json_iterator_next(channel_iterator))
-                        {
-                            JsonToken *i = json_get_token(channel_iterator);
-                            JsonToken *v = json_peek_next_token(channel_iterator);
+                        JsonToken *i = json_get_token(channel_iterator);
+                        JsonToken *v = json_peek_next_token(channel_iterator);
 
-                            if (v && v->type == JsonType_String)
+                        if (v && v->type == JsonType_String)
+                        {
+                            if (json_string_token_equals(json_string, i, "name"))
                             {
-                                if (json_string_token_equals(json_string, i, "name"))
-                                {
-                                    char *name_src = json_string + v->start;
-                                    i32 name_length = v->end - v->start;
-                                    copy_string_and_null_terminate(name_src, name, name_length);
-                                }
-                                else if (json_string_token_equals(json_string, i, "display_name"))
-                                {
-                                    char *display_name_src = json_string + v->start;
-                                    i32 display_name_length = v->end - v->start;
-                                    copy_string_and_null_terminate(display_name_src, display_name, display_name_length);
-                                }
-                                else if (json_string_token_equals(json_string, i, "logo"))
+                                char *name_src = json_string + v->start;
+                                i32 name_length = v->end - v->start;
+                                copy_string_and_null_terminate(name_src, name, name_length);
+                            }
+                            else if (json_string_token_equals(json_string, i, "display_name"))
+                            {
+                                char *display_name_src = json_string + v->start;
+                                i32 display_name_length = v->end - v->start;
+                                copy_string_and_null_terminate(display_name_src, display_name, display_name_length);
+                            }
+                            else if (json_string_token_equals(json_string, i, "logo"))
+                            {
+                                char *logo_src = json_string + v->start;
+                                i32 logo_length = v->end - v->start;
+                                copy_string_and_null_terminate(logo_src, logo, logo_length);
+                            }
+                            else if (json_string_token_equals(json_string, i, "status"))
+                            {
+                                char *title_src = json_string + v->start;
+                                i32 title_length = v->end - v->start;
+                                if (title_length < (i32)array_count(title))
                                 {
-                                    char *logo_src = json_string + v->start;
-                                    i32 logo_length = v->end - v->start;
-                                    copy_string_and_null_terminate(logo_src, logo, logo_length);
+                                    copy_string_and_null_terminate(title_src, title, title_length);
                                 }
                             }
                         }
                     }
                 }
+            }
 
-                notify_or_update_online_stream(name, game, display_name, logo);
+            Stream *updated_stream = notify_or_update_online_stream(name, game, title, display_name, logo);
+            if (updated_stream)
+            {
+                updated_stream->fingerprint = fingerprint;
+                updated_stream->viewers = viewers;
+            }
+        }
+
+        for (u32 batch_index = 0; batch_index < batch->count; ++batch_index)
+        {
+            Stream *stream = streams + batch->stream_indices[batch_index];
+            if (!stream->online)
+            {
+                stream->fingerprint = 0;
+                stream->viewers = 0;
             }
         }
     }
+
+    return valid;
 }
 
 static void add_stream(char *name, u32 name_length)
@@ -170,6 +684,7 @@ static void add_stream(char *name, u32 name_length)
     stream->game[0] = 0;
     stream->online = false;
     stream->was_online = false;
+    stream->poll_interval = POLL_DEFAULT_INTERVAL_SECS;
 
     copy_string_and_null_terminate(name, stream->name, name_length);
 }
@@ -207,6 +722,88 @@ static void load_streams(char *filename)
     platform.unload_file(file);
 }
 
+static u32 parse_u32(char *at, u32 length)
+{
+    u32 value = 0;
+    for (u32 char_index = 0; char_index < length && at[char_index] >= '0' && at[char_index] <= '9'; ++char_index)
+    {
+        value = value * 10 + (at[char_index] - '0');
+    }
+    return value;
+}
+
+static void set_setting(char *name, u32 name_length, char *value, u32 value_length)
+{
+    char name_string[64];
+    if (name_length < array_count(name_string))
+    {
+        copy_string_and_null_terminate(name, name_string, name_length);
+
+        if (strings_equal(name_string, "logo_cache_max_kb"))
+        {
+            settings.logo_cache_max_kb = parse_u32(value, value_length);
+        }
+        else if (strings_equal(name_string, "logo_cache_max_entries"))
+        {
+            settings.logo_cache_max_entries = parse_u32(value, value_length);
+        }
+        else if (strings_equal(name_string, "logo_warmup"))
+        {
+            settings.logo_warmup = (parse_u32(value, value_length) != 0);
+        }
+        else if (strings_equal(name_string, "logo_warmup_threads"))
+        {
+            settings.logo_warmup_threads = parse_u32(value, value_length);
+        }
+        else if (strings_equal(name_string, "poll_interval_secs"))
+        {
+            settings.poll_interval_secs = parse_u32(value, value_length);
+        }
+    }
+}
+
+// NOTE(dan): optional file of name=value lines, lines starting with # are comments
+static void load_settings(char *filename)
+{
+    settings.logo_cache_max_kb = LOGO_CACHE_DEFAULT_MAX_KB;
+    settings.logo_cache_max_entries = LOGO_CACHE_DEFAULT_MAX_ENTRIES;
+    settings.logo_warmup = true;
+    settings.logo_warmup_threads = 2;
+    settings.poll_interval_secs = POLL_DEFAULT_INTERVAL_SECS;
+
+    LoadedFile file = platform.load_file(filename);
+    char *data = (char *)file.contents;
+    u32 begin = 0;
+
+    while (begin < file.size)
+    {
+        u32 end = begin;
+        u32 equals = 0;
+        while (end < file.size && data[end] != '\n' && data[end] != '\r')
+        {
+            if (!equals && data[end] == '=')
+            {
+                equals = end;
+            }
+            ++end;
+        }
+
+        if (equals && data[begin] != '#')
+        {
+            set_setting(data + begin, equals - begin, data + equals + 1, end - equals - 1);
+        }
+
+        while (end < file.size && (data[end] == '\n' || data[end] == '\r'))
+        {
+            ++end;
+        }
+
+        begin = end;
+    }
+
+    platform.unload_file(file);
+}
+
 static void init_users_url(char *base_url, char *url)
 {
     copy_string(base_url, url);
@@ -227,7 +824,7 @@ static void init_users_url(char *base_url, char *url)
     url[at] = 0;
 }
 
-static void store_id_for_stream(char *name, char *id)
+static void store_user_for_stream(char *name, char *id, char *logo_url)
 {
     Stream *stream = get_stream_by_name(name);
     assert(stream);
@@ -238,17 +835,28 @@ static void store_id_for_stream(char *name, char *id)
 
         assert((id_length + 1) < array_count(stream->channel_id));
         copy_string_and_null_terminate(id, stream->channel_id, id_length);
+
+        u32 logo_url_length = string_length(logo_url);
+        if (logo_url_length < array_count(stream->logo_url))
+        {
+            copy_string_and_null_terminate(logo_url, stream->logo_url, logo_url_length);
+            stream->logo_hash = logo_url_length ? djb2_hash(logo_url) : 0;
+        }
     }
 }
 
-static void query_user_ids(void *data, u32 data_size)
+// NOTE(dan): returns false for a response that is cut off, the query is tried again
+static b32 query_user_ids(void *data, u32 data_size)
 {
     char *json_string = (char *)data;
-    JsonToken tokens[1024] = {};
     JsonParser parser;
 
-    json_init_parser(&parser, tokens, array_count(tokens));
+    json_init_parser(&parser, response_tokens, array_count(response_tokens));
     json_parse(&parser, (char *)data, data_size);
+    if (parser.status != JsonParserStatus_Success)
+    {
+        return false;
+    }
 
     for (JsonIterator root_iterator = json_iterator_get(&parser, 0); json_iterator_valid(root_iterator); root_iterator = json_iterator_next(root_iterator))
     {
@@ -263,9 +871,11 @@ static void query_user_ids(void *data, u32 data_size)
 
                 char name[256];
                 char id[256];
+                char logo[512];
 
                 name[0] = 0;
                 id[0]   = 0;
+                logo[0] = 0;
 
                 for (JsonIterator user_iterator = json_iterator_get(&parser, user); json_iterator_valid(user_iterator); user_iterator = json_iterator_next(user_iterator))
                 {
@@ -284,40 +894,360 @@ static void query_user_ids(void *data, u32 data_size)
                         i32 id_length = val->end - val->start;
                         copy_string_and_null_terminate(id_src, id, id_length);
                     }
+                    else if (val && val->type == JsonType_String && json_string_token_equals(json_string, ident, "logo"))
+                    {
+                        char *logo_src  = json_string + val->start;
+                        i32 logo_length = val->end - val->start;
+                        if (logo_length < (i32)array_count(logo))
+                        {
+                            copy_string_and_null_terminate(logo_src, logo, logo_length);
+                        }
+                    }
                 }
 
-                store_id_for_stream(name, id);
+                store_user_for_stream(name, id, logo);
             }
         }
     }
+
+    users_resolved = true;
+    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    {
+        Stream *stream = streams + stream_index;
+        stream->not_exists_on_twitch = (string_length(stream->channel_id) == 0);
+    }
+
+    // NOTE(dan): readers learn which channels don't exist before the first poll, there are no viewer samples yet
+    publish_stream_snapshot(0);
+    return true;
 }
 
-static void init_streams_url(char *base_url, char *url)
+// NOTE(dan): every channel that exists is due right away, after that each one is
+// polled on its own interval
+static void begin_update_cycle(UpdateCycle *cycle, f64 start, u64 time)
 {
-    copy_string(base_url, url);
+    u32 poll_interval = settings.poll_interval_secs ? settings.poll_interval_secs : POLL_DEFAULT_INTERVAL_SECS;
 
-    u32 at = string_length(base_url);
-    u32 valid_stream_count = 0;
+    cycle->start = start;
+    cycle->deadline = start + (f64)poll_interval / UPDATE_CYCLE_BUDGET_DIVISOR;
+    cycle->time = time;
+}
+
+// NOTE(dan): cycles are spaced by their start times, a long cycle doesn't shift the
+// ones after it. the ticks it ran into are skipped, not caught up with, and only
+// count as missed when the cycle also went over its budget. waiting on the network
+// within the budget is not an overrun. returns when the next cycle starts
+static f64 end_update_cycle(UpdateCycle *cycle, f64 now, f64 interval)
+{
+    CycleStats *stats = &cycle_stats;
+    ++stats->cycles;
+
+    stats->last_duration_ms = (u32)((now - cycle->start)*1000.0);
+    if (stats->max_duration_ms < stats->last_duration_ms)
+    {
+        stats->max_duration_ms = stats->last_duration_ms;
+    }
+
+    b32 overran = (now > cycle->deadline);
+    if (overran)
+    {
+        ++stats->overruns;
+    }
+
+    f64 next_start = cycle->start + interval;
+    if (now >= next_start)
+    {
+        u64 skipped_ticks = (u64)((now - next_start) / interval) + 1;
+        next_start += skipped_ticks*interval;
+        if (overran)
+        {
+            stats->missed_ticks += skipped_ticks;
+        }
+    }
+    return next_start;
+}
 
+// NOTE(dan): once the users query went through, at startup or later on the update thread
+static void start_stream_polls(u64 now)
+{
     for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
     {
-        Stream *stream = streams + stream_index;
+        if (string_length(streams[stream_index].channel_id))
+        {
+            schedule_poll(&poll_scheduler, stream_index, now);
+        }
+    }
+}
 
-        u32 channel_id_length = string_length(stream->channel_id);
-        if (channel_id_length)
+static void init_stream_polls(u64 now)
+{
+    init_poll_scheduler(&poll_scheduler, poll_timers, num_streams, now);
+
+    u32 poll_interval = settings.poll_interval_secs ? settings.poll_interval_secs : POLL_DEFAULT_INTERVAL_SECS;
+    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    {
+        streams[stream_index].poll_interval = poll_interval;
+    }
+
+    if (users_resolved)
+    {
+        start_stream_polls(now);
+    }
+}
+
+// NOTE(dan): takes the next due channels and builds their streams request, returns
+// how many channels it has, zero when nothing is due
+static u32 begin_poll_batch(PollBatch *batch, char *base_url, char *url)
+{
+    batch->count = take_due_polls(&poll_scheduler, batch->stream_indices, array_count(batch->stream_indices));
+
+    copy_string(base_url, url);
+    u32 at = string_length(base_url);
+    for (u32 batch_index = 0; batch_index < batch->count; ++batch_index)
+    {
+        Stream *stream = streams + batch->stream_indices[batch_index];
+        if (batch_index)
+        {
+            url[at++] = ',';
+        }
+
+        copy_string(stream->channel_id, url + at);
+        at += string_length(stream->channel_id);
+    }
+    url[at] = 0;
+
+    return batch->count;
+}
+
+inline void seed_poll_random(u32 seed)
+{
+    poll_random_state = seed ? seed : 1;
+}
+
+// NOTE(dan): xorshift, only spreads retries apart
+inline u32 next_poll_random()
+{
+    u32 x = poll_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    poll_random_state = x;
+    return x;
+}
+
+// NOTE(dan): exponential backoff with equal jitter, channels that failed together
+// still retry together but not at the same time as other batches
+static u32 get_poll_retry_delay(u32 failures)
+{
+    u32 delay = POLL_RETRY_MAX_SECS;
+    if (failures < 16)
+    {
+        delay = POLL_RETRY_BASE_SECS << (failures - 1);
+        if (delay > POLL_RETRY_MAX_SECS)
+        {
+            delay = POLL_RETRY_MAX_SECS;
+        }
+    }
+
+    delay = delay / 2 + next_poll_random() % (delay / 2 + 1);
+    return delay ? delay : 1;
+}
+
+// NOTE(dan): data is the response of the batch request, zero when it failed. a failed
+// or cut off batch keeps its previous state and is retried with backoff.
+// now is the poll scheduler's clock, wall_seconds the time of day the models use
+static void end_poll_batch(PollBatch *batch, u64 now, u64 wall_seconds, void *data, u32 data_size)
+{
+    b32 succeeded = data && update_streams(batch, data, data_size);
+    if (succeeded)
+    {
+        for (u32 batch_index = 0; batch_index < batch->count; ++batch_index)
         {
-            if (valid_stream_count++ != 0)
+            Stream *stream = streams + batch->stream_indices[batch_index];
+            if (stream->polled && stream->online && !stream->was_online)
             {
-                url[at++] = ',';
+                u64 went_live = stream->last_poll_wall_seconds + (wall_seconds - stream->last_poll_wall_seconds) / 2;
+                record_go_live(&stream->poll_model, went_live);
+                poll_models_changed = true;
+            }
+            if (stream->online)
+            {
+                append_viewer_sample(viewer_series + batch->stream_indices[batch_index], wall_seconds, stream->viewers);
+            }
+            stream->polled = true;
+            stream->last_poll_wall_seconds = wall_seconds;
+            stream->poll_failures = 0;
+
+            // NOTE(dan): a live channel only has to be watched for going offline
+            u32 interval = stream->poll_interval;
+            if (!stream->online)
+            {
+                interval = get_adaptive_poll_interval(&stream->poll_model, wall_seconds, stream->poll_interval);
             }
 
-            copy_string(stream->channel_id, url + at);
-            at += channel_id_length;
+            // NOTE(dan): deadlines sit on the interval's grid, so channels due around the
+            // same time are due on the same tick and go out in one request
+            u64 deadline = ((now / interval) + 1) * interval;
+            schedule_poll(&poll_scheduler, batch->stream_indices[batch_index], deadline);
+        }
+    }
+    else
+    {
+        u32 failures = 0;
+        for (u32 batch_index = 0; batch_index < batch->count; ++batch_index)
+        {
+            Stream *stream = streams + batch->stream_indices[batch_index];
+            if (failures < stream->poll_failures)
+            {
+                failures = stream->poll_failures;
+            }
         }
-        else
+        ++failures;
+
+        u64 deadline = now + get_poll_retry_delay(failures);
+        for (u32 batch_index = 0; batch_index < batch->count; ++batch_index)
         {
-            stream->not_exists_on_twitch = true;
+            u32 stream_index = batch->stream_indices[batch_index];
+            streams[stream_index].poll_failures = failures;
+            schedule_poll(&poll_scheduler, stream_index, deadline);
+        }
+    }
+}
+
+static void load_poll_models(char *filename)
+{
+    LoadedFile file = platform.load_file(filename);
+    PollModelFile *model_file = (PollModelFile *)file.contents;
+
+    if (file.size >= sizeof(PollModelFileHeader) &&
+        model_file->header.magic == POLL_MODEL_FILE_MAGIC &&
+        model_file->header.version == POLL_MODEL_FILE_VERSION &&
+        model_file->header.num_entries <= MAX_STREAMS &&
+        file.size >= sizeof(PollModelFileHeader) + model_file->header.num_entries*sizeof(PollModelFileEntry))
+    {
+        for (u32 entry_index = 0; entry_index < model_file->header.num_entries; ++entry_index)
+        {
+            PollModelFileEntry *entry = model_file->entries + entry_index;
+            for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+            {
+                Stream *stream = streams + stream_index;
+                if (djb2_hash(stream->name) == entry->name_hash)
+                {
+                    stream->poll_model = entry->model;
+                    break;
+                }
+            }
+        }
+    }
+
+    platform.unload_file(file);
+}
+
+// NOTE(dan): after the users query and before the update thread starts. a channel
+// that was live is taken as announced already and its session goes on, unless the
+// state is too old to tell it's the same stream. channels the query didn't resolve
+// aren't polled, they stay offline
+static void load_stream_states(char *filename, u64 now)
+{
+    LoadedFile file = platform.load_file(filename);
+    StreamStateFile *state_file = (StreamStateFile *)file.contents;
+
+    if (file.size >= sizeof(StreamStateFileHeader) &&
+        state_file->header.magic == STREAM_STATE_FILE_MAGIC &&
+        state_file->header.version == STREAM_STATE_FILE_VERSION &&
+        state_file->header.num_entries <= MAX_STREAMS &&
+        file.size >= sizeof(StreamStateFileHeader) + state_file->header.num_entries*sizeof(StreamStateFileEntry) &&
+        state_file->header.saved_time <= now && now - state_file->header.saved_time <= STREAM_STATE_MAX_AGE_SECS)
+    {
+        for (u32 entry_index = 0; entry_index < state_file->header.num_entries; ++entry_index)
+        {
+            StreamStateFileEntry *entry = state_file->entries + entry_index;
+            entry->game[array_count(entry->game) - 1] = 0;
+            entry->title[array_count(entry->title) - 1] = 0;
+
+            for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+            {
+                Stream *stream = streams + stream_index;
+                if (djb2_hash(stream->name) == entry->name_hash)
+                {
+                    if (entry->online && string_length(stream->channel_id))
+                    {
+                        stream->online = true;
+                        stream->was_online = true;
+                        stream->published_online = true;
+                        if (!stream->logo_hash)
+                        {
+                            stream->logo_hash = entry->logo_hash;
+                        }
+                        copy_string(entry->game, stream->game);
+                        copy_string(entry->game, stream->published_game);
+                        copy_string(entry->title, stream->title);
+                        copy_string(entry->title, stream->published_title);
+
+                        u64 session_start = entry->session_start ? entry->session_start : state_file->header.saved_time;
+                        resume_open_session(&session_history, stream_index, session_start, stream->game);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    platform.unload_file(file);
+}
+
+// NOTE(dan): runs on the update thread at the end of every cycle that did something.
+// the file is replaced as a whole, a crash leaves either the old or the new one
+static void save_stream_states(char *filename, u64 time)
+{
+    StreamStateFile *state_file = &stream_state_file;
+    state_file->header.magic = STREAM_STATE_FILE_MAGIC;
+    state_file->header.version = STREAM_STATE_FILE_VERSION;
+    state_file->header.num_entries = num_streams;
+    state_file->header.saved_time = time;
+
+    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    {
+        Stream *stream = streams + stream_index;
+        StreamStateFileEntry *entry = state_file->entries + stream_index;
+        entry->name_hash = djb2_hash(stream->name);
+
+        // NOTE(dan): what was announced, a go-live still waiting for its logo wasn't
+        entry->online = stream->published_online;
+        entry->logo_hash = stream->logo_hash;
+
+        OpenSession *session = session_history.open_sessions + stream_index;
+        entry->session_start = session->open ? session->start : 0;
+        copy_string(stream->published_game, entry->game);
+        copy_string(stream->published_title, entry->title);
+    }
+
+    u32 size = (u32)(sizeof(StreamStateFileHeader) + num_streams*sizeof(StreamStateFileEntry));
+    platform.write_entire_file(filename, state_file, size);
+}
+
+// NOTE(dan): runs on the update thread, only when a go-live was recorded
+static void save_poll_models(char *filename)
+{
+    if (poll_models_changed)
+    {
+        PollModelFile *model_file = &poll_model_file;
+        model_file->header.magic = POLL_MODEL_FILE_MAGIC;
+        model_file->header.version = POLL_MODEL_FILE_VERSION;
+        model_file->header.num_entries = num_streams;
+
+        for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+        {
+            Stream *stream = streams + stream_index;
+            PollModelFileEntry *entry = model_file->entries + stream_index;
+            entry->name_hash = djb2_hash(stream->name);
+            entry->model = stream->poll_model;
+        }
+
+        u32 size = (u32)(sizeof(PollModelFileHeader) + num_streams*sizeof(PollModelFileEntry));
+        if (platform.write_entire_file(filename, model_file, size))
+        {
+            poll_models_changed = false;
         }
     }
-    url[at] = 0;
 }
@@ -16,22 +16,29 @@
 #define STBIR_ASSERT assert
 #include "stb_image_resize.h"
 
+#if LOGO_EXPORT_PNG
 #pragma warning(disable: 4996)
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #define STBIW_ASSERT assert
 #include "stb_image_write.h"
+#endif
 
 #include "whosalive.cpp"
 
-#define UPDATE_THREAD_TIMER_ID      1
 #define FADER_TIMER_ID              2
-#define UPDATE_THREAD_INTERVAL_MS   (60 * 1000)
+#define OVERLAY_FADE_IN_SECS        0.4
+#define OVERLAY_SHOWN_SECS          5.0
+#define OVERLAY_FADE_OUT_SECS       0.6
+#define UPDATE_THREAD_TICK_MS       1000 // NOTE(dan): the poll scheduler's resolution
 #define MAX_DOWNLOAD_SIZE           (1*MB)
 #define TRAY_ICON_MESSAGE           (WM_USER + 1)
+#define STREAM_EVENTS_MESSAGE       (WM_USER + 2)
 
-#define LOGO_EXPIRES_DAYS           7
-#define LOGO_EXPIRES_SECS           (LOGO_EXPIRES_DAYS * 24 * 60 * 60)
-#define LOGO_EXPIRES_NS             (LOGO_EXPIRES_SECS * 10000000LL)
+#define HTTP_STATUS_TOO_MANY_REQUESTS   429
+#define UNIX_EPOCH_IN_FILETIME_SECS     11644473600ULL
+
+#define LOGO_SIZE                   60
+#define USERS_QUERY_STARTUP_ATTEMPTS    3 // NOTE(dan): then the update thread keeps trying
 
 static char *global_headers = "Accept: application/vnd.twitchtv.v5+json\r\nClient-ID: j6dzqx92ht08vnyr1ghz0a1fdw6oss";
 
@@ -43,12 +50,26 @@ static char query_streams_url[4096];
 
 static void *global_download_buffer;
 
+static u32 global_users_query_failures;
+static f64 global_next_users_query;
+
 static Win32State global_win32_state_;
 static Win32State *global_win32_state = &global_win32_state_;
 
 static HINTERNET global_internet;
-static HANDLE global_update_event;
 static Win32Overlay global_overlay;
+static GlyphAtlas global_glyph_atlas;
+static CardCache global_card_cache;
+static CardStack global_card_stack;
+static u32 global_ui_snapshot_reader;
+static LogoCache global_logo_cache;
+static Win32LogoWarmup global_logo_warmup;
+static u32 volatile global_logo_cache_maintenance_queued;
+static Win32WorkerPool global_worker_pool;
+static RequestBudget global_request_budget;
+static u64 global_performance_frequency;
+static Animator global_animator;
+static Animation global_overlay_fade;
 
 Platform platform;
 
@@ -96,75 +117,120 @@ static void win32_change_opacity(Win32Window *window, i32 alpha)
     UpdateLayeredWindow(window->hwnd, 0, 0, 0, 0, 0, 0, &blend_func, ULW_ALPHA);
 }
 
-static void win32_fading(Win32Window *window)
+static f64 win32_get_monotonic_seconds()
 {
-    win32_change_opacity(window, window->alpha);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
 
-    SetTimer(window->hwnd, FADER_TIMER_ID, 5, 0);
+    f64 seconds = (f64)counter.QuadPart / (f64)global_performance_frequency;
+    return seconds;
 }
 
-static void win32_fade_in(Win32Window *window)
+static u64 win32_get_seconds()
 {
-    window->alpha = 0;
-    window->state = Win32WindowState_FadingIn;
+    FILETIME current_time;
+    GetSystemTimeAsFileTime(&current_time);
 
-    win32_change_opacity(window, 0);
+    u64 now = ((u64)current_time.dwHighDateTime << 32) + current_time.dwLowDateTime;
+    return now / 10000000;
+}
+
+inline u64 win32_get_unix_seconds()
+{
+    u64 now = win32_get_seconds() - UNIX_EPOCH_IN_FILETIME_SECS;
+    return now;
+}
+
+// NOTE(dan): one timer wakes up all the animations, and it only runs while something is due
+static void win32_schedule_animation_frame(Win32Window *window, f64 now)
+{
+    f64 next_frame = get_next_animation_frame(&global_animator, now);
+    if (next_frame < 0)
+    {
+        KillTimer(window->hwnd, FADER_TIMER_ID);
+    }
+    else
+    {
+        u32 next_frame_ms = (u32)(next_frame * 1000.0 + 0.5);
+        if (next_frame_ms < 1)
+        {
+            next_frame_ms = 1;
+        }
+        SetTimer(window->hwnd, FADER_TIMER_ID, next_frame_ms, 0);
+    }
+}
 
-    ShowWindow(window->hwnd, SW_SHOW);
-    SetTimer(window->hwnd, FADER_TIMER_ID, 5, 0);
+static void win32_apply_fade(Win32Window *window)
+{
+    i32 alpha = (i32)(global_overlay_fade.value + 0.5f);
+    if (alpha != window->alpha)
+    {
+        window->alpha = alpha;
+        win32_change_opacity(window, alpha);
+    }
 }
 
-static void win32_fade_out(Win32Window *window)
+// NOTE(dan): a visible overlay fades back in from where it is, so new cards don't blink
+static void win32_fade_in(Win32Window *window)
 {
-    window->state = Win32WindowState_FadingOut;
+    f64 now = win32_get_monotonic_seconds();
 
-    SetTimer(window->hwnd, FADER_TIMER_ID, 5000, 0);
+    if (window->state == Win32WindowState_Hidden)
+    {
+        window->alpha = 0;
+        win32_change_opacity(window, 0);
+        ShowWindow(window->hwnd, SW_SHOW);
+    }
+    window->state = Win32WindowState_FadingIn;
+
+    f32 from = (f32)window->alpha;
+    f64 duration = OVERLAY_FADE_IN_SECS * (255.0f - from) / 255.0f;
+    start_animation(&global_animator, &global_overlay_fade, now, 0, duration, from, 255.0f, Easing_OutCubic);
+    win32_schedule_animation_frame(window, now);
 }
 
 static void win32_update_window(Win32Window *window)
 {
+    f64 now = win32_get_monotonic_seconds();
+    animate(&global_animator, now);
+
     switch (window->state)
     {
         case Win32WindowState_FadingIn:
         {
-            if (window->alpha == 255)
+            win32_apply_fade(window);
+            if (global_overlay_fade.finished)
             {
+                // NOTE(dan): the fade out sleeps through the time the card is shown
                 window->state = Win32WindowState_Shown;
+                start_animation(&global_animator, &global_overlay_fade, now, OVERLAY_SHOWN_SECS, OVERLAY_FADE_OUT_SECS,
+                                255.0f, 0.0f, Easing_InCubic);
             }
-            else
-            {
-                ++window->alpha;
-                if (window->alpha > 255)
-                {
-                    window->alpha = 255;
-                }
-            }
-
-            win32_fading(window);
         } break;
 
+        case Win32WindowState_Shown:
         case Win32WindowState_FadingOut:
         {
-            --window->alpha;
-            if (window->alpha < 1)
+            if (now >= global_overlay_fade.start)
             {
-                window->state = Win32WindowState_Hidden;
+                window->state = Win32WindowState_FadingOut;
             }
 
-            win32_fading(window);
-        } break;
-
-        case Win32WindowState_Shown:
-        {
-            win32_fade_out(window);
+            win32_apply_fade(window);
+            if (global_overlay_fade.finished)
+            {
+                window->state = Win32WindowState_Hidden;
+                ShowWindow(window->hwnd, SW_HIDE);
+            }
         } break;
 
         case Win32WindowState_Hidden:
         {
-            ShowWindow(window->hwnd, SW_HIDE);
-            KillTimer(window->hwnd, FADER_TIMER_ID);
+            stop_animation(&global_animator, &global_overlay_fade);
         } break;
     }
+
+    win32_schedule_animation_frame(window, now);
 }
 
 enum TrayIconMenuID
@@ -192,14 +258,23 @@ static void win32_create_tray_menu(HWND window)
     POINT mouse;
     GetCursorPos(&mouse);
 
+    // NOTE(dan): names never change after startup, the states come from one snapshot
+    StreamSnapshot *snapshot = begin_snapshot_read(&stream_snapshots, global_ui_snapshot_reader);
+    u32 num_snapshot_streams = snapshot ? snapshot->num_streams : 0;
+
     u32 num_online = 0;
-    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    for (u32 stream_index = 0; stream_index < num_snapshot_streams; ++stream_index)
     {
         Stream *stream = streams + stream_index;
-        if (stream->online)
+        StreamState *state = snapshot->streams + stream_index;
+        if (state->online)
         {
             i32 cmd_id = TrayIconMenuID_Count + stream_index;
-            AppendMenu(menu, MF_CHECKED, cmd_id, stream->name);
+
+            char item_text[192];
+            wsprintf(item_text, "%s  (%u viewers, 24h peak %u, average %u)",
+                     stream->name, state->viewers, state->peak_viewers, state->average_viewers);
+            AppendMenu(menu, MF_CHECKED, cmd_id, item_text);
 
             ++num_online;
         }
@@ -211,13 +286,33 @@ static void win32_create_tray_menu(HWND window)
     }
 
     u32 num_offline = 0;
+    u64 unix_now = win32_get_unix_seconds();
     for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
     {
         Stream *stream = streams + stream_index;
-        if (!stream->online)
+        if ((stream_index >= num_snapshot_streams) || !snapshot->streams[stream_index].online)
         {
             i32 cmd_id = TrayIconMenuID_Count + stream_index;
-            AppendMenu(menu, MF_UNCHECKED, cmd_id, stream->name);
+
+            char item_text[192];
+            u64 last_session_end = (stream_index < num_snapshot_streams) ? snapshot->streams[stream_index].last_session_end : 0;
+            if (last_session_end && unix_now >= last_session_end)
+            {
+                u64 hours_ago = (unix_now - last_session_end) / 3600;
+                if (hours_ago < 48)
+                {
+                    wsprintf(item_text, "%s  (live %u h ago)", stream->name, (u32)hours_ago);
+                }
+                else
+                {
+                    wsprintf(item_text, "%s  (live %u days ago)", stream->name, (u32)(hours_ago / 24));
+                }
+            }
+            else
+            {
+                copy_string(stream->name, item_text);
+            }
+            AppendMenu(menu, MF_UNCHECKED, cmd_id, item_text);
 
             ++num_offline;
         }
@@ -229,16 +324,24 @@ static void win32_create_tray_menu(HWND window)
     }
 
     u32 num_invalid = 0;
-    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    for (u32 stream_index = 0; stream_index < num_snapshot_streams; ++stream_index)
     {
         Stream *stream = streams + stream_index;
-        if (stream->not_exists_on_twitch)
+        if (snapshot->streams[stream_index].not_exists_on_twitch)
         {
             i32 cmd_id = TrayIconMenuID_Count + stream_index;
             AppendMenu(menu, MF_DISABLED, cmd_id, stream->name);
         }
     }
 
+    CycleStats update_stats = {};
+    if (snapshot)
+    {
+        update_stats = snapshot->cycle_stats;
+    }
+
+    end_snapshot_read(&stream_snapshots, global_ui_snapshot_reader);
+
     if (!num_offline && !num_online && !num_invalid)
     {
         AppendMenu(menu, MF_DISABLED, 0, "Put the newline separated usernames list into streams.txt file next to this program");
@@ -248,6 +351,18 @@ static void win32_create_tray_menu(HWND window)
         AppendMenu(menu, MF_SEPARATOR, 0, 0);
     }
 
+    LogoCache *logo_cache = &global_logo_cache;
+    char logo_cache_stats[128];
+    wsprintf(logo_cache_stats, "Logo cache: %u logos, %u of %u KB, %u evicted",
+             logo_cache->num_entries, (u32)(logo_cache->total_bytes / KB), (u32)(logo_cache->max_bytes / KB), (u32)logo_cache->evictions);
+    AppendMenu(menu, MF_DISABLED, 0, logo_cache_stats);
+
+    char cycle_stats_text[128];
+    wsprintf(cycle_stats_text, "Update cycles: %u, last %u ms, max %u ms, %u overruns",
+             (u32)update_stats.cycles, update_stats.last_duration_ms, update_stats.max_duration_ms, (u32)update_stats.overruns);
+    AppendMenu(menu, MF_DISABLED, 0, cycle_stats_text);
+    AppendMenu(menu, MF_SEPARATOR, 0, 0);
+
     AppendMenu(menu, MF_UNCHECKED, TrayIconMenuID_Exit, "Exit");
 
     SetForegroundWindow(window);
@@ -284,12 +399,9 @@ static intptr __stdcall win32_window_proc(HWND wnd, unsigned int message, uintpt
             global_win32_state->quit_requested = true;
         } break;
 
-        case WM_TIMER:
+        case STREAM_EVENTS_MESSAGE:
         {
-            if (wparam == UPDATE_THREAD_TIMER_ID)
-            {
-                SetEvent(global_update_event);
-            }
+            process_stream_events();
         } break;
 
         case TRAY_ICON_MESSAGE:
@@ -308,63 +420,198 @@ static intptr __stdcall win32_window_proc(HWND wnd, unsigned int message, uintpt
     return result;
 }
 
-static void win32_update()
+static u32 win32_get_status_code(HINTERNET connection)
+{
+    u32 status_code = 0;
+    u32 size = sizeof(status_code);
+    HttpQueryInfo(connection, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &status_code, (DWORD *)&size, 0);
+    return status_code;
+}
+
+static void win32_get_response_header(HINTERNET connection, u32 query, char *out, u32 max_out_size)
+{
+    u32 size = max_out_size - 1;
+    if (!HttpQueryInfo(connection, query, out, (DWORD *)&size, 0))
+    {
+        size = 0;
+    }
+    out[size] = 0;
+}
+
+// NOTE(dan): wininet looks a header up by name when the buffer starts with the name
+static b32 win32_get_custom_header_u32(HINTERNET connection, char *name, u32 *value)
 {
-    HINTERNET connection = InternetOpenUrlA(global_internet, query_streams_url, global_headers, (unsigned int)-1, INTERNET_FLAG_EXISTING_CONNECT | INTERNET_FLAG_KEEP_CONNECTION | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_SECURE, 0);
+    char header[64];
+    copy_string(name, header);
+
+    u32 size = array_count(header) - 1;
+    b32 found = HttpQueryInfo(connection, HTTP_QUERY_CUSTOM, header, (DWORD *)&size, 0);
+    if (found)
+    {
+        *value = parse_u32(header, size);
+    }
+    return found;
+}
+
+// NOTE(dan): every request goes through here, it waits for the request budget and
+// feeds the rate limit headers and 429s of the response back into it
+static HINTERNET win32_open_request(char *url, char *headers, RequestPriority priority)
+{
+    RequestBudget *budget = &global_request_budget;
+    for (;;)
+    {
+        f64 wait = acquire_request(budget, priority, win32_get_monotonic_seconds());
+        if (wait <= 0.0)
+        {
+            break;
+        }
+        Sleep((u32)(wait*1000.0) + 1);
+    }
+
+    HINTERNET connection = InternetOpenUrlA(global_internet, url, headers, (unsigned int)-1, INTERNET_FLAG_EXISTING_CONNECT | INTERNET_FLAG_KEEP_CONNECTION | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_SECURE, 0);
     if (connection)
     {
-        unsigned int total_bytes_read = 0;
-        unsigned int bytes_to_read = MAX_DOWNLOAD_SIZE;
-        unsigned int bytes_read;
+        f64 now = win32_get_monotonic_seconds();
 
-        while (InternetReadFile(connection, (char *)global_download_buffer + total_bytes_read, bytes_to_read, (DWORD *)&bytes_read))
+        // NOTE(dan): Ratelimit-Reset is the unix time the bucket is full again
+        f64 reset_in = 0.0;
+        u32 reset;
+        if (win32_get_custom_header_u32(connection, "Ratelimit-Reset", &reset))
         {
-            if (!bytes_read)
+            u64 unix_now = win32_get_unix_seconds();
+            if (reset > unix_now)
             {
-                break;
+                reset_in = (f64)(reset - unix_now);
             }
-            total_bytes_read += bytes_read;
         }
 
-        pre_update_streams();
-        update_streams(global_download_buffer, total_bytes_read);
-        post_update_streams();
+        u32 limit = 0;
+        u32 remaining;
+        win32_get_custom_header_u32(connection, "Ratelimit-Limit", &limit);
+        if (win32_get_custom_header_u32(connection, "Ratelimit-Remaining", &remaining))
+        {
+            update_request_budget(budget, now, limit, remaining, reset_in);
+        }
 
-        InternetCloseHandle(connection);
+        if (win32_get_status_code(connection) == HTTP_STATUS_TOO_MANY_REQUESTS)
+        {
+            throttle_request_budget(budget, now, (reset_in > 0.0) ? reset_in : 1.0);
+        }
     }
+    return connection;
 }
 
-static void *win32_allocate(usize size)
+static u32 win32_read_response(HINTERNET connection, void *buffer, u32 buffer_size)
 {
-    void *memory = VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-    return memory;
+    u32 total_bytes_read = 0;
+    u32 bytes_read;
+
+    while (total_bytes_read < buffer_size &&
+           InternetReadFile(connection, (char *)buffer + total_bytes_read, buffer_size - total_bytes_read, (DWORD *)&bytes_read))
+    {
+        if (!bytes_read)
+        {
+            break;
+        }
+        total_bytes_read += bytes_read;
+    }
+    return total_bytes_read;
 }
 
-static DWORD __stdcall win32_update_thread_proc(void *data)
+// NOTE(dan): one try of the users query, a failed one is tried again after the poll backoff
+static b32 win32_try_query_user_ids()
 {
-    while (WaitForSingleObject(global_update_event, 0xFFFFFFFF) == WAIT_OBJECT_0)
+    b32 succeeded = false;
+    HINTERNET connection = win32_open_request(query_users_url, global_headers, RequestPriority_Poll);
+    if (connection)
+    {
+        if (win32_get_status_code(connection) == HTTP_STATUS_OK)
+        {
+            u32 total_bytes_read = win32_read_response(connection, global_download_buffer, MAX_DOWNLOAD_SIZE);
+            succeeded = query_user_ids((char *)global_download_buffer, total_bytes_read);
+        }
+        InternetCloseHandle(connection);
+    }
+
+    if (!succeeded)
     {
-        win32_update();
+        ++global_users_query_failures;
+        global_next_users_query = win32_get_monotonic_seconds() + get_poll_retry_delay(global_users_query_failures);
     }
-    return 0;
+    return succeeded;
 }
 
-static void win32_init_update_thread(Win32State *state)
+// NOTE(dan): runs every tick, polls the channels that are due in as few requests as
+// possible and returns whether it polled any. batches that don't start before the
+// cycle's deadline stay due for the next cycle
+static b32 win32_update(UpdateCycle *cycle)
 {
-    global_update_event = CreateEventA(0, 0, 0, 0);
-    if (global_update_event)
-    {    
-        uintptr timer = SetTimer(state->window.hwnd, UPDATE_THREAD_TIMER_ID, UPDATE_THREAD_INTERVAL_MS, 0);
-        if (timer)
+    u64 now = (u64)cycle->start;
+    u64 wall_seconds = cycle->time;
+    advance_poll_scheduler(&poll_scheduler, now);
+
+    // NOTE(dan): channels resolved late start the way they would have at startup
+    if (!users_resolved && win32_get_monotonic_seconds() >= global_next_users_query && win32_try_query_user_ids())
+    {
+        load_stream_states(global_win32_state->stream_states_filename, wall_seconds);
+        start_stream_polls(now);
+    }
+
+    b32 polled = false;
+    PollBatch batch;
+    for (;;)
+    {
+        if (win32_get_monotonic_seconds() >= cycle->deadline)
         {
-            SetEvent(global_update_event);
+            if (poll_scheduler.num_due)
+            {
+                ++cycle_stats.deferred_batches;
+            }
+            break;
+        }
+
+        if (!begin_poll_batch(&batch, query_streams_url_base, query_streams_url))
+        {
+            break;
+        }
 
-            HANDLE update_thread = CreateThread(0, 0, win32_update_thread_proc, 0, 0, 0);
-            if (update_thread)
+        // NOTE(dan): only a 200 says anything about who's live, a throttled or failed
+        // request must not make the whole batch look offline
+        b32 succeeded = false;
+        HINTERNET connection = win32_open_request(query_streams_url, global_headers, RequestPriority_Poll);
+        if (connection)
+        {
+            if (win32_get_status_code(connection) == HTTP_STATUS_OK)
             {
+                u32 total_bytes_read = win32_read_response(connection, global_download_buffer, MAX_DOWNLOAD_SIZE);
+                end_poll_batch(&batch, now, wall_seconds, global_download_buffer, total_bytes_read);
+                succeeded = true;
             }
+            InternetCloseHandle(connection);
         }
+
+        if (!succeeded)
+        {
+            end_poll_batch(&batch, now, wall_seconds, 0, 0);
+        }
+        polled = true;
     }
+
+    if (polled || stream_changes_pending)
+    {
+        post_update_streams(cycle);
+        update_session_history(&session_history, &transition_log);
+        save_poll_models(global_win32_state->poll_models_filename);
+        save_stream_states(global_win32_state->stream_states_filename, cycle->time);
+    }
+
+    return polled;
+}
+
+static void *win32_allocate(usize size)
+{
+    void *memory = VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    return memory;
 }
 
 static intptr __stdcall win32_overlay_window_proc(HWND wnd, unsigned int message, uintptr wparam, intptr lparam)
@@ -404,6 +651,21 @@ static void win32_build_filename(char *pathname, u32 pathname_size,
     }
 }
 
+static void win32_build_temp_filename(char *filename, char *out, u32 max_out_size)
+{
+    win32_build_filename(global_win32_state->temp_path, global_win32_state->temp_path_length,
+                         filename, string_length(filename),
+                         out, max_out_size);
+}
+
+static void win32_build_logo_filename(u32 logo_hash, char *out, u32 max_out_size)
+{
+    char filename[32];
+    wsprintf(filename, "%u.logo", logo_hash);
+
+    win32_build_temp_filename(filename, out, max_out_size);
+}
+
 static void win32_init_paths(Win32State *state)
 {
     state->exe_filename_length = GetModuleFileNameA(0, state->exe_filename, sizeof(state->exe_filename));
@@ -423,6 +685,11 @@ static void win32_init_paths(Win32State *state)
                          streams_filename, array_count(streams_filename),
                          state->streams_filename, MAX_FILENAME_SIZE);
 
+    char settings_filename[] = "settings.txt";
+    win32_build_filename(state->exe_filename, state->exe_path_length,
+                         settings_filename, array_count(settings_filename),
+                         state->settings_filename, MAX_FILENAME_SIZE);
+
     state->temp_path_length = GetTempPath(MAX_FILENAME_SIZE, state->temp_path);
 
     char whosalive_dir[] = "whosalive\\";
@@ -433,6 +700,83 @@ static void win32_init_paths(Win32State *state)
     state->temp_path[state->temp_path_length] = '\0';
 
     CreateDirectory(state->temp_path, 0);
+
+    char poll_models_filename[] = "poll_models.dat";
+    win32_build_temp_filename(poll_models_filename, state->poll_models_filename, MAX_FILENAME_SIZE);
+
+    char stream_states_filename[] = "stream_states.dat";
+    win32_build_temp_filename(stream_states_filename, state->stream_states_filename, MAX_FILENAME_SIZE);
+
+    char history_dir[] = "history\\";
+    win32_build_temp_filename(history_dir, state->history_path, MAX_FILENAME_SIZE);
+    CreateDirectory(state->history_path, 0);
+}
+
+static void win32_bake_font(GlyphAtlas *atlas, FontId font_id, int height, int weight)
+{
+    HDC dc = CreateCompatibleDC(0);
+    HFONT font = CreateFont(height, 0, 0, 0, weight, 0, 0, 0, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FW_DONTCARE, "Arial");
+    SelectObject(dc, font);
+
+    TEXTMETRIC text_metric;
+    GetTextMetrics(dc, &text_metric);
+
+    Font *baked = atlas->fonts + font_id;
+    baked->height = text_metric.tmHeight;
+    baked->ascent = text_metric.tmAscent;
+
+    MAT2 identity = {{0, 1}, {0, 0}, {0, 0}, {0, 1}};
+    static u8 glyph_buffer[64 * 64];
+
+    for (u32 c = FIRST_GLYPH; c <= LAST_GLYPH; ++c)
+    {
+        Glyph *glyph = baked->glyphs + (c - FIRST_GLYPH);
+
+        GLYPHMETRICS metrics;
+        u32 size = GetGlyphOutlineA(dc, c, GGO_GRAY8_BITMAP, &metrics, sizeof(glyph_buffer), glyph_buffer, &identity);
+        glyph->advance = (i16)metrics.gmCellIncX;
+        glyph->offset_x = (i16)metrics.gmptGlyphOrigin.x;
+        glyph->offset_y = (i16)metrics.gmptGlyphOrigin.y;
+
+        // NOTE(dan): blank glyphs like space only have metrics
+        u32 width = 0;
+        u32 height = 0;
+        if ((size != GDI_ERROR) && (size > 0))
+        {
+            width = metrics.gmBlackBoxX;
+            height = metrics.gmBlackBoxY;
+        }
+
+        if (allocate_glyph(atlas, width, height, glyph))
+        {
+            // NOTE(dan): rows are dword aligned and coverage goes from 0 to 64
+            u32 src_pitch = (width + 3) & ~3;
+            for (u32 y = 0; y < height; ++y)
+            {
+                u8 *src = glyph_buffer + y * src_pitch;
+                u8 *dest = atlas->coverage + (glyph->y + y) * GLYPH_ATLAS_WIDTH + glyph->x;
+                for (u32 x = 0; x < width; ++x)
+                {
+                    u32 coverage = src[x] * 255 / 64;
+                    dest[x] = (u8)coverage;
+                }
+            }
+        }
+        else
+        {
+            glyph->width = 0;
+            glyph->height = 0;
+        }
+    }
+
+    DeleteObject(font);
+    DeleteDC(dc);
+}
+
+static void win32_bake_glyph_atlas(GlyphAtlas *atlas)
+{
+    win32_bake_font(atlas, FontId_Header, 18, FW_BOLD);
+    win32_bake_font(atlas, FontId_Message, 16, FW_NORMAL);
 }
 
 static Win32Overlay win32_create_overlay(int width, int height)
@@ -449,163 +793,338 @@ static Win32Overlay win32_create_overlay(int width, int height)
 
     void *pixels;
     Win32Overlay overlay = {0};
-    overlay.width = width;
-    overlay.height = height;
     overlay.bitmap = CreateDIBSection(screen_dc, &bitmap_info, DIB_RGB_COLORS, &pixels, 0, 0);
     overlay.draw_dc = CreateCompatibleDC(screen_dc);
+
+    overlay.width = width;
+    overlay.height = height;
     overlay.stride = -width * 4;
     overlay.top_left_corner = (unsigned char *)pixels + (height - 1) * (width * 4);
-    overlay.header_font = CreateFont(18, 0, 0, 0, FW_BOLD, 0, 0, 0, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY, DEFAULT_PITCH | FW_DONTCARE, "Arial");
-    overlay.message_font = CreateFont(16, 0, 0, 0, FW_NORMAL, 0, 0, 0, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY, DEFAULT_PITCH | FW_DONTCARE, "Arial");
 
     ReleaseDC(0, screen_dc);
     return overlay;
 }
 
-inline void win32_set_pixel(Win32Overlay *overlay, int x, int y, unsigned int color)
+static void win32_render_card(Bitmap *card_bitmap, char *header, char *message, u32 logo_hash)
+{
+    begin_card_cache(&global_card_cache);
+    if (!card_cache_copy(&global_card_cache, card_bitmap, header, message, logo_hash))
+    {
+        char path_to_file[MAX_FILENAME_SIZE];
+        win32_build_logo_filename(logo_hash, path_to_file, array_count(path_to_file));
+
+        logo_cache_begin_render(&global_logo_cache, logo_hash);
+
+        LoadedFile logo_file = platform.load_file(path_to_file);
+        Logo logo;
+        b32 has_logo = parse_logo_file(logo_file.contents, logo_file.size, &logo);
+
+        card_cache_render(&global_card_cache, card_bitmap, &global_glyph_atlas, header, message, logo_hash, has_logo ? &logo : 0);
+
+        platform.unload_file(logo_file);
+
+        logo_cache_end_render(&global_logo_cache);
+    }
+    end_card_cache(&global_card_cache);
+}
+
+static void win32_create_overlay_graphics(Win32Overlay *overlay, CardStack *stack)
 {
-    assert(x < overlay->width);
-    assert(y < overlay->height);
+    GdiFlush();
 
-    int row = y * overlay->stride;
-    int col = x * 4;
+    // NOTE(dan): the DIB is bottom-up, the renderer walks it with a negative pitch
+    Bitmap surface;
+    surface.width = overlay->width;
+    surface.height = overlay->height;
+    surface.pitch = overlay->stride;
+    surface.memory = overlay->top_left_corner;
 
-    unsigned int *pixel = (unsigned int *)(overlay->top_left_corner + row + col);
-    *pixel = color;
+    for (u32 card_index = 0; card_index < stack->num_cards; ++card_index)
+    {
+        Notification *card = stack->cards + card_index;
+        Bitmap card_bitmap = get_stacked_card_bitmap(&surface, card_index);
+        win32_render_card(&card_bitmap, card->title, card->message, card->logo_hash);
+    }
+    clear_card_stack_gaps(&surface, stack);
 }
 
-static void win32_round_corners(Win32Overlay *overlay, int top_left_x, int top_left_y, int width, int height, unsigned int fade_color)
+// NOTE(dan): the whole burst is drawn into the surface first and presented once,
+// the window grows upwards from the corner to fit the stack
+static PLATFORM_SHOW_NOTIFICATIONS(win32_show_notifications)
 {
-    // NOTE(dan): garbage stuff just for my OCD
+    Win32Overlay *overlay = &global_overlay;
+    Win32Window *window = &global_win32_state->overlay;
 
-    // NOTE(dan): top-left corner
-    win32_set_pixel(overlay, top_left_x + 0, top_left_y + 0, fade_color);
-    win32_set_pixel(overlay, top_left_x + 1, top_left_y + 0, 0x60d6dadb);
-    win32_set_pixel(overlay, top_left_x + 0, top_left_y + 1, 0x60d6dadb);
+    // NOTE(dan): cards that already faded out are not brought back
+    if (window->state == Win32WindowState_Hidden)
+    {
+        global_card_stack.num_cards = 0;
+    }
+    push_notifications(&global_card_stack, notifications, count);
 
-    // NOTE(dan): top-right corner
-    win32_set_pixel(overlay, top_left_x + width - 1, top_left_y + 0, fade_color);
-    win32_set_pixel(overlay, top_left_x + width - 2, top_left_y + 0, 0x60d6dadb);
-    win32_set_pixel(overlay, top_left_x + width - 1, top_left_y + 1, 0x60d6dadb);
+    win32_create_overlay_graphics(overlay, &global_card_stack);
 
-    // NOTE(dan): bottom-left corner
-    win32_set_pixel(overlay, top_left_x + 0, top_left_y + height - 1, fade_color);
-    win32_set_pixel(overlay, top_left_x + 1, top_left_y + height - 1, 0x60d6dadb);
-    win32_set_pixel(overlay, top_left_x + 0, top_left_y + height - 2, 0x60d6dadb);
+    i32 stack_height = get_card_stack_height(&global_card_stack);
+    SIZE size = {overlay->width, stack_height};
+    POINT position = {(LONG)window->x, (LONG)(window->y + window->height) - stack_height};
+    POINT zero = {0};
 
-    // NOTE(dan): bottom-right corner
-    win32_set_pixel(overlay, top_left_x + width - 1, top_left_y + height - 1, fade_color);
-    win32_set_pixel(overlay, top_left_x + width - 2, top_left_y + height - 1, 0x60d6dadb);
-    win32_set_pixel(overlay, top_left_x + width - 1, top_left_y + height - 2, 0x60d6dadb);
+    BLENDFUNCTION blend_func = {0};
+    blend_func.BlendOp = AC_SRC_OVER;
+    blend_func.SourceConstantAlpha = (BYTE)window->alpha;
+    blend_func.AlphaFormat = AC_SRC_ALPHA;
+
+    SelectObject(overlay->draw_dc, overlay->bitmap);
+
+    HDC screen_dc = GetDC(0);
+    UpdateLayeredWindow(window->hwnd, screen_dc, &position, &size, overlay->draw_dc, &zero, RGB(0, 0, 0), &blend_func, ULW_ALPHA);
+    ReleaseDC(0, screen_dc);
+
+    win32_fade_in(window);
 }
 
-static void win32_create_overlay_graphics(Win32Overlay *overlay, char *header, char *message, u32 logo_hash)
+// NOTE(dan): called from the update thread, the events are processed on the UI thread
+static PLATFORM_SIGNAL_EVENTS(win32_signal_events)
 {
-    SelectObject(overlay->draw_dc, overlay->bitmap);
+    PostMessageA(global_win32_state->window.hwnd, STREAM_EVENTS_MESSAGE, 0, 0);
+}
+
+static void win32_init_work_queue(PlatformWorkQueue *queue, u32 num_rings)
+{
+    queue->completion_goal = 0;
+    queue->completion_count = 0;
+    queue->next_ring = 0;
+    queue->num_rings = num_rings;
 
-    // NOTE(dan): background
-    for (int y = 0; y < overlay->height; ++y)
+    for (u32 ring_index = 0; ring_index < num_rings; ++ring_index)
     {
-        for (int x = 0; x < overlay->width; ++x)
+        Win32WorkRing *ring = queue->rings + ring_index;
+        ring->enqueue_position = 0;
+        ring->dequeue_position = 0;
+        for (u32 cell_index = 0; cell_index < WORK_RING_SIZE; ++cell_index)
         {
-            int row = y * overlay->stride;
-            int col = x * 4;
+            ring->cells[cell_index].sequence = cell_index;
+        }
+    }
+}
+
+// NOTE(dan): a cell's sequence tells whose turn it is, so producers and consumers
+// only race for the positions and never wait on each other
+static b32 win32_push_work(Win32WorkRing *ring, Win32WorkEntry *entry)
+{
+    b32 pushed = false;
 
-            unsigned int *pixel = (unsigned int *)(overlay->top_left_corner + row + col);
-            *pixel = 0xFFFFFFFF;
+    u32 position = ring->enqueue_position;
+    for (;;)
+    {
+        Win32WorkCell *cell = ring->cells + (position & (WORK_RING_SIZE - 1));
+        i32 difference = (i32)(cell->sequence - position);
+        if (difference == 0)
+        {
+            u32 original = atomic_compare_exchange_u32(&ring->enqueue_position, position + 1, position);
+            if (original == position)
+            {
+                cell->entry = *entry;
+
+                complete_previous_writes_before_future_writes;
+                cell->sequence = position + 1;
+                pushed = true;
+                break;
+            }
+            position = original;
+        }
+        else if (difference < 0)
+        {
+            // NOTE(dan): full
+            break;
+        }
+        else
+        {
+            position = ring->enqueue_position;
         }
     }
+    return pushed;
+}
+
+static b32 win32_pop_work(Win32WorkRing *ring, Win32WorkEntry *entry)
+{
+    b32 popped = false;
 
-    win32_round_corners(overlay, 0, 0, overlay->width, overlay->height, 0x00000000);
+    u32 position = ring->dequeue_position;
+    for (;;)
+    {
+        Win32WorkCell *cell = ring->cells + (position & (WORK_RING_SIZE - 1));
+        i32 difference = (i32)(cell->sequence - (position + 1));
+        if (difference == 0)
+        {
+            u32 original = atomic_compare_exchange_u32(&ring->dequeue_position, position + 1, position);
+            if (original == position)
+            {
+                complete_previous_reads_before_future_reads;
+                *entry = cell->entry;
 
-    // NOTE(dan): header
-    SelectObject(overlay->draw_dc, overlay->header_font);
-    SetTextColor(overlay->draw_dc, 0xFF454545);
+                complete_previous_writes_before_future_writes;
+                cell->sequence = position + WORK_RING_SIZE;
+                popped = true;
+                break;
+            }
+            position = original;
+        }
+        else if (difference < 0)
+        {
+            // NOTE(dan): empty
+            break;
+        }
+        else
+        {
+            position = ring->dequeue_position;
+        }
+    }
+    return popped;
+}
 
-    RECT text_rect = {0};
-    text_rect.top = 10;
-    text_rect.left = 80;
-    text_rect.right = overlay->width - 10;
-    text_rect.bottom = overlay->height - 10;
+// NOTE(dan): the ring a thread prefers, its own on workers and a rotating one elsewhere
+static u32 win32_get_home_ring(PlatformWorkQueue *queue)
+{
+    u32 ring_index;
 
-    DrawText(overlay->draw_dc, header, string_length(header), &text_rect, DT_LEFT | DT_SINGLELINE);
+    u32 worker = (u32)(uintptr)TlsGetValue(global_worker_pool.tls_index);
+    if (worker)
+    {
+        ring_index = worker - 1;
+    }
+    else
+    {
+        ring_index = atomic_add_u32(&queue->next_ring, 1) % queue->num_rings;
+    }
+    return ring_index;
+}
 
-    // NOTE(dan): message
-    SelectObject(overlay->draw_dc, overlay->message_font);
-    SetTextColor(overlay->draw_dc, 0xFF878787);
+static PLATFORM_ADD_WORK(win32_add_work)
+{
+    Win32WorkEntry entry;
+    entry.callback = callback;
+    entry.data = data;
 
-    TEXTMETRIC text_metric;
-    GetTextMetrics(overlay->draw_dc, &text_metric);
+    atomic_add_u32(&queue->completion_goal, 1);
 
-    text_rect.top += text_metric.tmHeight + 10;
-    DrawText(overlay->draw_dc, message, string_length(message), &text_rect, DT_LEFT | DT_SINGLELINE);
+    b32 pushed = false;
+    u32 home_ring = win32_get_home_ring(queue);
+    for (u32 ring_offset = 0; ring_offset < queue->num_rings; ++ring_offset)
+    {
+        Win32WorkRing *ring = queue->rings + ((home_ring + ring_offset) % queue->num_rings);
+        if (win32_push_work(ring, &entry))
+        {
+            pushed = true;
+            break;
+        }
+    }
 
-    // NOTE(dan): logo
-    SelectObject(overlay->draw_dc, overlay->bitmap);
+    if (pushed)
+    {
+        ReleaseSemaphore(global_worker_pool.semaphore, 1, 0);
+    }
+    else
+    {
+        // NOTE(dan): every ring is full, the work is never dropped
+        callback(queue, data);
+        atomic_add_u32(&queue->completion_count, 1);
+    }
+}
 
-    char filename[32];
-    wsprintf(filename, "%u.png", logo_hash);
+// NOTE(dan): own ring first, then steal from the others
+static b32 win32_do_next_work(PlatformWorkQueue *queue, u32 home_ring)
+{
+    b32 did_work = false;
 
-    char path_to_file[MAX_FILENAME_SIZE];
-    win32_build_filename(global_win32_state->temp_path, global_win32_state->temp_path_length,
-                         filename, string_length(filename),
-                         path_to_file, array_count(path_to_file));
-    
-    int logo_width, logo_height, n;
-    LoadedFile logo = platform.load_file(path_to_file);
-    if (logo.contents)
+    Win32WorkEntry entry;
+    for (u32 ring_offset = 0; ring_offset < queue->num_rings; ++ring_offset)
     {
-        unsigned char *image = stbi_load_from_memory((unsigned char *)logo.contents, logo.size, &logo_width, &logo_height, &n, 0);
-        if (image)
+        Win32WorkRing *ring = queue->rings + ((home_ring + ring_offset) % queue->num_rings);
+        if (win32_pop_work(ring, &entry))
         {
-            int top_left_x = 10;
-            int top_left_y = 10;
+            entry.callback(queue, entry.data);
+            atomic_add_u32(&queue->completion_count, 1);
 
-            for (int y = 0; y < logo_height; ++y)
-            {
-                for (int x = 0; x < logo_width; ++x)
-                {
-                    int src_row = y * logo_width * n;
-                    int src_col = x * n;
-                    unsigned int *src_pixel = (unsigned int *)(image + src_row + src_col);
+            did_work = true;
+            break;
+        }
+    }
+    return did_work;
+}
 
-                    int dest_row = (top_left_y + y) * overlay->stride;
-                    int dest_col = (top_left_x + x) * 4;
-                    unsigned int *dest_pixel = (unsigned int *)(overlay->top_left_corner + dest_row + dest_col);
+static PLATFORM_COMPLETE_WORK_BEFORE(win32_complete_work_before)
+{
+    u32 home_ring = win32_get_home_ring(queue);
+    while (queue->completion_count != queue->completion_goal &&
+           win32_get_monotonic_seconds() < deadline)
+    {
+        if (!win32_do_next_work(queue, home_ring))
+        {
+            Sleep(1);
+        }
+    }
 
-                    *dest_pixel = *src_pixel | (0xFF << 24);
-                }
-            }
-            stbi_image_free(image);
+    b32 completed = (queue->completion_count == queue->completion_goal);
+    return completed;
+}
 
-            win32_round_corners(overlay, top_left_x, top_left_y, logo_width, logo_height, 0x00FFFFFFFF);
+static PLATFORM_COMPLETE_ALL_WORK(win32_complete_all_work)
+{
+    u32 home_ring = win32_get_home_ring(queue);
+    while (queue->completion_count != queue->completion_goal)
+    {
+        if (!win32_do_next_work(queue, home_ring))
+        {
+            // NOTE(dan): the rest is already running on the workers
+            Sleep(0);
         }
-        platform.unload_file(logo);
     }
 }
 
-static PLATFORM_SHOW_NOTIFICATION(win32_show_notification)
+static DWORD __stdcall win32_worker_thread_proc(void *data)
 {
-    Win32Overlay *overlay = &global_overlay;
-    Win32Window *window = &global_win32_state->overlay;
+    u32 worker_index = (u32)(uintptr)data;
+    TlsSetValue(global_worker_pool.tls_index, (void *)(uintptr)(worker_index + 1));
 
-    win32_create_overlay_graphics(overlay, title, message, logo_hash);
+    Win32WorkerPool *pool = &global_worker_pool;
+    for (;;)
+    {
+        if (!win32_do_next_work(&pool->high_priority_queue, worker_index) &&
+            !win32_do_next_work(&pool->low_priority_queue, worker_index))
+        {
+            WaitForSingleObject(pool->semaphore, 0xFFFFFFFF);
+        }
+    }
+}
 
-    SIZE size = {overlay->width, overlay->height};
-    POINT zero = {0};
+static void win32_init_worker_pool(Win32WorkerPool *pool)
+{
+    // NOTE(dan): one core is left for the UI and the update thread
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
 
-    BLENDFUNCTION blend_func = {0};
-    blend_func.BlendOp = AC_SRC_OVER;
-    blend_func.SourceConstantAlpha = 255;
-    blend_func.AlphaFormat = AC_SRC_ALPHA;
+    pool->num_workers = system_info.dwNumberOfProcessors - 1;
+    if (pool->num_workers < 1)
+    {
+        pool->num_workers = 1;
+    }
+    if (pool->num_workers > MAX_WORKER_THREADS)
+    {
+        pool->num_workers = MAX_WORKER_THREADS;
+    }
 
-    SelectObject(overlay->draw_dc, overlay->bitmap);
+    pool->semaphore = CreateSemaphoreA(0, 0, 0x7FFFFFFF, 0);
+    pool->tls_index = TlsAlloc();
 
-    HDC screen_dc = GetDC(0);
-    UpdateLayeredWindow(window->hwnd, screen_dc, 0, &size, overlay->draw_dc, &zero, RGB(0, 0, 0), &blend_func, ULW_ALPHA);
-    ReleaseDC(0, screen_dc);
+    win32_init_work_queue(&pool->high_priority_queue, pool->num_workers);
+    win32_init_work_queue(&pool->low_priority_queue, pool->num_workers);
 
-    win32_fade_in(window);
+    for (u32 worker_index = 0; worker_index < pool->num_workers; ++worker_index)
+    {
+        HANDLE thread = CreateThread(0, 0, win32_worker_thread_proc, (void *)(uintptr)worker_index, 0, 0);
+        CloseHandle(thread);
+    }
 }
 
 static void win32_free(void *memory)
@@ -655,109 +1174,416 @@ static PLATFORM_LOAD_FILE(win32_load_file)
     return file;
 }
 
-static void *win32_create_logo_if_not_exists(char *path_to_file, b32 *created)
+// NOTE(dan): writes next to the file first and renames it over, so readers never see half a file
+static PLATFORM_WRITE_ENTIRE_FILE(win32_write_entire_file)
 {
-    *created = false;
-    WIN32_FILE_ATTRIBUTE_DATA data;
-    u32 creation_flags = OPEN_EXISTING;
-    if (!GetFileAttributesEx(path_to_file, GetFileExInfoStandard, &data))
+    b32 result = false;
+
+    char temp_filename[MAX_FILENAME_SIZE];
+    // NOTE(dan): several jobs may write the same file at once, each gets its own temp file
+    wsprintf(temp_filename, "%s.%u.tmp", filename, GetCurrentThreadId());
+
+    HANDLE handle = CreateFileA(temp_filename, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, 0, 0);
+    if (handle != INVALID_HANDLE_VALUE)
     {
-        creation_flags = CREATE_NEW;
-        *created = true;
+        u32 bytes_written;
+        b32 written = (WriteFile(handle, memory, size, (DWORD *)&bytes_written, 0) && bytes_written == size);
+
+        // NOTE(dan): the data has to be on disk before the rename is, or a power loss can
+        // leave the new name on a file that never got its contents
+        written = written && FlushFileBuffers(handle);
+        CloseHandle(handle);
+
+        if (written)
+        {
+            result = MoveFileExA(temp_filename, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+        }
     }
-    else
+    return result;
+}
+
+static PLATFORM_MAP_FILE(win32_map_file)
+{
+    b32 result = false;
+    *file = {};
+
+    HANDLE handle = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0,
+                                create ? OPEN_ALWAYS : OPEN_EXISTING, 0, 0);
+    if (handle != INVALID_HANDLE_VALUE)
+    {
+        // NOTE(dan): the mapping grows the file to its size, the new part reads as zeros
+        HANDLE mapping = CreateFileMappingA(handle, 0, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, 0);
+        if (mapping)
+        {
+            void *memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+            if (memory)
+            {
+                file->memory = memory;
+                file->size = size;
+                file->file_handle = handle;
+                file->mapping_handle = mapping;
+                result = true;
+            }
+            else
+            {
+                CloseHandle(mapping);
+            }
+        }
+
+        if (!result)
+        {
+            CloseHandle(handle);
+        }
+    }
+    return result;
+}
+
+static PLATFORM_UNMAP_FILE(win32_unmap_file)
+{
+    if (file->memory)
     {
-        FILETIME current_time;
-        GetSystemTimeAsFileTime(&current_time);
+        UnmapViewOfFile(file->memory);
+        CloseHandle((HANDLE)file->mapping_handle);
+        CloseHandle((HANDLE)file->file_handle);
+    }
+    *file = {};
+}
 
-        u64 last_write = ((u64)data.ftLastWriteTime.dwHighDateTime << 32) + data.ftLastWriteTime.dwLowDateTime;
-        u64 now = ((u64)current_time.dwHighDateTime << 32) + current_time.dwLowDateTime;
-        u64 expires = last_write + LOGO_EXPIRES_NS;
+static PLATFORM_FLUSH_MAPPED_FILE(win32_flush_mapped_file)
+{
+    if (file->memory && offset < file->size)
+    {
+        // NOTE(dan): the view flush only hands the pages to the system, the file buffers
+        // flush is the one that waits for the disk
+        FlushViewOfFile((u8 *)file->memory + offset, (SIZE_T)size);
+        FlushFileBuffers((HANDLE)file->file_handle);
+    }
+}
 
-        if (expires < now)
+static PLATFORM_DELETE_FILE(win32_delete_file)
+{
+    DeleteFileA(filename);
+}
+
+static u32 win32_store_logo(char *path_to_file, void *data, u32 data_size, u64 expires, LogoValidators *validators)
+{
+    u32 stored_size = 0;
+
+    // NOTE(dan): big jpegs are decoded at reduced scale straight away, the resize only has to do the rest.
+    // images keep their own channel count, opaque or gray logos don't pay for a fourth channel
+    int x, y, n;
+    unsigned char *image = stbi_load_from_memory_scaled((unsigned char *)data, data_size, &x, &y, &n, 0, LOGO_SIZE, LOGO_SIZE);
+    if (image)
+    {
+        unsigned char *resized_image = (unsigned char *)win32_allocate(LOGO_SIZE * LOGO_SIZE * n);
+        stbir_resize_uint8(image, x, y, 0,
+                           resized_image, LOGO_SIZE, LOGO_SIZE, 0,
+                           n);
+
+        u32 file_size = get_logo_file_size(LOGO_SIZE, LOGO_SIZE);
+        void *file_memory = win32_allocate(file_size);
+        write_logo_file(file_memory, resized_image, n, LOGO_SIZE, LOGO_SIZE, expires, validators);
+        if (win32_write_entire_file(path_to_file, file_memory, file_size))
         {
-            *created = true;
-            creation_flags = TRUNCATE_EXISTING;
+            stored_size = file_size;
         }
+
+#if LOGO_EXPORT_PNG
+        char png_filename[MAX_FILENAME_SIZE];
+        wsprintf(png_filename, "%s.png", path_to_file);
+        stbi_write_png(png_filename, LOGO_SIZE, LOGO_SIZE, n, resized_image, 0);
+#endif
+
+        stbi_image_free(image);
+        win32_free(file_memory);
+        win32_free(resized_image);
     }
-    void *handle = CreateFileA(path_to_file, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, 0, creation_flags, 0, 0);
-    return handle;
+    return stored_size;
 }
 
-static PLATFORM_CACHE_LOGO(win32_cache_logo)
+// NOTE(dan): returns whether it had to go to the network
+static b32 win32_fetch_logo(char *url, u32 logo_hash, void *download_buffer, RequestPriority priority)
 {
-    char filename[32];
-    wsprintf(filename, "%u.png", logo_hash);
+    b32 requested = false;
 
     char path_to_file[MAX_FILENAME_SIZE];
-    win32_build_filename(global_win32_state->temp_path, global_win32_state->temp_path_length,
-                         filename, string_length(filename), 
-                         path_to_file, array_count(path_to_file));
+    win32_build_logo_filename(logo_hash, path_to_file, array_count(path_to_file));
 
-    b32 created;
-    HANDLE logo = win32_create_logo_if_not_exists(path_to_file, &created);
-    assert(logo);
-    CloseHandle(logo);
+    u64 now = win32_get_seconds();
 
-    if (created)
+    LoadedFile cached_file = win32_load_file(path_to_file);
+    Logo cached;
+    b32 cached_valid = parse_logo_file(cached_file.contents, cached_file.size, &cached);
+
+    if (!cached_valid || logo_expired(&cached, now))
     {
-        HINTERNET connection = InternetOpenUrlA(global_internet, url, global_headers, (unsigned int)-1, INTERNET_FLAG_EXISTING_CONNECT | INTERNET_FLAG_KEEP_CONNECTION | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_SECURE, 0);
-        if (connection)
+        char headers[1024];
+        copy_string(global_headers, headers);
+
+        // NOTE(dan): revalidate what we have, an unchanged logo is only a 304
+        if (cached_valid)
         {
-            void *data = global_download_buffer;
-            u32 total_bytes_read = 0;
-            u32 bytes_to_read = MAX_DOWNLOAD_SIZE;
-            u32 bytes_read;
+            LogoValidators *validators = &cached.header->validators;
+            if (validators->etag[0])
+            {
+                wsprintf(headers + string_length(headers), "\r\nIf-None-Match: %s", validators->etag);
+            }
+            if (validators->last_modified[0])
+            {
+                wsprintf(headers + string_length(headers), "\r\nIf-Modified-Since: %s", validators->last_modified);
+            }
+        }
 
-            while (InternetReadFile(connection, (char *)data + total_bytes_read, bytes_to_read, (DWORD *)&bytes_read))
+        requested = true;
+
+        HINTERNET connection = win32_open_request(url, headers, priority);
+        if (connection)
+        {
+            u32 status_code = win32_get_status_code(connection);
+            if (status_code == HTTP_STATUS_NOT_MODIFIED && cached_valid)
             {
-                if (!bytes_read)
+                cached.header->expires = get_logo_expiry(logo_hash, now);
+                if (win32_write_entire_file(path_to_file, cached_file.contents, cached_file.size))
                 {
-                    break;
+                    logo_cache_insert(&global_logo_cache, logo_hash, cached_file.size);
                 }
-                total_bytes_read += bytes_read;
             }
-     
-            int x, y, n;
-            unsigned char *image = stbi_load_from_memory((unsigned char *)data, total_bytes_read, &x, &y, &n, 0);
-            if (image)
+            else if (status_code == HTTP_STATUS_OK)
             {
-                unsigned char *resized_image = (unsigned char *)win32_allocate(total_bytes_read);
-                stbir_resize_uint8(image, x, y, 0,
-                                   resized_image, 60, 60, 0,
-                                   n);
-
-                stbi_write_png(path_to_file, 60, 60, n, resized_image, 0);
-                stbi_image_free(image);
-                win32_free(resized_image);
+                LogoValidators validators = {};
+                win32_get_response_header(connection, HTTP_QUERY_ETAG, validators.etag, array_count(validators.etag));
+                win32_get_response_header(connection, HTTP_QUERY_LAST_MODIFIED, validators.last_modified, array_count(validators.last_modified));
+
+                u32 total_bytes_read = win32_read_response(connection, download_buffer, MAX_DOWNLOAD_SIZE);
+                u32 stored_size = win32_store_logo(path_to_file, download_buffer, total_bytes_read, get_logo_expiry(logo_hash, now), &validators);
+                if (stored_size)
+                {
+                    logo_cache_insert(&global_logo_cache, logo_hash, stored_size);
+                    invalidate_cached_cards(&global_card_cache, logo_hash);
+                }
             }
 
             InternetCloseHandle(connection);
         }
     }
+
+    win32_unload_file(cached_file);
+    return requested;
 }
 
-static void win32_query_user_ids()
+// NOTE(dan): runs on any thread, often several at once, so every call has its own buffer
+static PLATFORM_CACHE_LOGO(win32_cache_logo)
 {
-    HINTERNET connection = InternetOpenUrlA(global_internet, query_users_url, global_headers, (unsigned int)-1, INTERNET_FLAG_EXISTING_CONNECT | INTERNET_FLAG_KEEP_CONNECTION | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_SECURE, 0);
-    if (connection)
+    void *download_buffer = win32_allocate(MAX_DOWNLOAD_SIZE);
+    win32_fetch_logo(url, logo_hash, download_buffer, RequestPriority_Logo);
+    win32_free(download_buffer);
+}
+
+// NOTE(dan): one logo per job, the update thread hands them out a few at a time
+static PLATFORM_WORK_QUEUE_CALLBACK(win32_do_logo_warmup_work)
+{
+    Win32LogoWarmupItem *item = (Win32LogoWarmupItem *)data;
+    void *download_buffer = win32_allocate(MAX_DOWNLOAD_SIZE);
+
+    HANDLE thread = GetCurrentThread();
+    int priority = GetThreadPriority(thread);
+    SetThreadPriority(thread, THREAD_PRIORITY_LOWEST);
+
+    win32_fetch_logo(item->url, item->logo_hash, download_buffer, RequestPriority_Warmup);
+
+    SetThreadPriority(thread, priority);
+    win32_free(download_buffer);
+
+    complete_previous_writes_before_future_writes;
+    atomic_add_u32(&item->warmup->jobs_in_flight, (u32)-1);
+}
+
+// NOTE(dan): runs on the update thread between cycles, so live polls always go first.
+// a job is only queued while the budget has a token to spare for it, so the workers
+// never sit waiting on the budget for the warm-up
+static void win32_queue_logo_warmup(Win32LogoWarmup *warmup)
+{
+    while (warmup->next_item < warmup->num_items &&
+           warmup->jobs_in_flight < warmup->max_jobs_in_flight &&
+           request_budget_available(&global_request_budget, RequestPriority_Warmup, win32_get_monotonic_seconds()))
     {
-        unsigned int total_bytes_read = 0;
-        unsigned int bytes_to_read = MAX_DOWNLOAD_SIZE;
-        unsigned int bytes_read;
+        Win32LogoWarmupItem *item = warmup->items + warmup->next_item++;
+        atomic_add_u32(&warmup->jobs_in_flight, 1);
+        win32_add_work(platform.low_priority_queue, win32_do_logo_warmup_work, item);
+    }
+}
+
+// NOTE(dan): prefetches the logos of every known channel, so the first
+// notification of a channel doesn't have to wait for the download
+static void win32_start_logo_warmup(Win32LogoWarmup *warmup)
+{
+    warmup->next_item = 0;
+    warmup->num_items = 0;
+    warmup->jobs_in_flight = 0;
+    warmup->max_jobs_in_flight = settings.logo_warmup_threads;
+    if (warmup->max_jobs_in_flight > LOGO_WARMUP_MAX_JOBS)
+    {
+        warmup->max_jobs_in_flight = LOGO_WARMUP_MAX_JOBS;
+    }
+
+    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    {
+        Stream *stream = streams + stream_index;
+        if (stream->logo_url[0] && warmup->num_items < array_count(warmup->items))
+        {
+            Win32LogoWarmupItem *item = warmup->items + warmup->num_items++;
+            item->warmup = warmup;
+            item->logo_hash = stream->logo_hash;
+            copy_string(stream->logo_url, item->url);
+        }
+    }
+}
+
+static void win32_init_logo_cache(LogoCache *cache)
+{
+    init_logo_cache(cache, settings.logo_cache_max_kb * KB, settings.logo_cache_max_entries);
+
+    char index_filename[MAX_FILENAME_SIZE];
+    win32_build_temp_filename("logos.idx", index_filename, array_count(index_filename));
+
+    LoadedFile index = win32_load_file(index_filename);
+    read_logo_cache_index(cache, index.contents, index.size);
+    win32_unload_file(index);
+
+    // NOTE(dan): the files on disk are the truth, the index only keeps the use order
+    b32 *seen = (b32 *)win32_allocate(LOGO_CACHE_MAX_ENTRIES * sizeof(b32));
 
-        while (InternetReadFile(connection, (char *)global_download_buffer + total_bytes_read, bytes_to_read, (DWORD *)&bytes_read))
+    char wildcard[MAX_FILENAME_SIZE];
+    win32_build_temp_filename("*.logo", wildcard, array_count(wildcard));
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA(wildcard, &find_data);
+    if (find != INVALID_HANDLE_VALUE)
+    {
+        do
         {
-            if (!bytes_read)
+            char *at = find_data.cFileName;
+            u32 digits = 0;
+            while (at[digits] >= '0' && at[digits] <= '9')
             {
-                break;
+                ++digits;
             }
-            total_bytes_read += bytes_read;
+
+            if (digits && strings_equal(at + digits, ".logo"))
+            {
+                u32 logo_hash = parse_u32(at, digits);
+                reconcile_logo_cache_entry(cache, logo_hash, find_data.nFileSizeLow, seen);
+            }
+        } while (FindNextFileA(find, &find_data));
+
+        FindClose(find);
+    }
+
+    remove_unseen_logo_cache_entries(cache, seen);
+    win32_free(seen);
+}
+
+// NOTE(dan): runs on the update thread between cycles, never while a notification is rendered
+static void win32_maintain_logo_cache(LogoCache *cache)
+{
+    // NOTE(dan): renders and stores don't wait for the files to be deleted
+    u32 victims[LOGO_CACHE_MAX_DISPLACED];
+    for (;;)
+    {
+        u32 num_victims = logo_cache_take_victims(cache, victims, array_count(victims));
+        for (u32 victim_index = 0; victim_index < num_victims; ++victim_index)
+        {
+            char path_to_file[MAX_FILENAME_SIZE];
+            win32_build_logo_filename(victims[victim_index], path_to_file, array_count(path_to_file));
+
+            DeleteFileA(path_to_file);
         }
 
-        query_user_ids((char *)global_download_buffer, total_bytes_read);
+        if (num_victims < array_count(victims))
+        {
+            break;
+        }
+    }
 
-        InternetCloseHandle(connection);
+    if (logo_cache_is_dirty(cache))
+    {
+        char index_filename[MAX_FILENAME_SIZE];
+        win32_build_temp_filename("logos.idx", index_filename, array_count(index_filename));
+
+        void *index = win32_allocate(LOGO_CACHE_INDEX_MAX_SIZE);
+        u32 index_size = write_logo_cache_index(cache, index, LOGO_CACHE_INDEX_MAX_SIZE);
+        if (index_size)
+        {
+            win32_write_entire_file(index_filename, index, index_size);
+        }
+        win32_free(index);
+    }
+}
+
+static PLATFORM_WORK_QUEUE_CALLBACK(win32_do_logo_cache_maintenance_work)
+{
+    win32_maintain_logo_cache((LogoCache *)data);
+    atomic_compare_exchange_u32(&global_logo_cache_maintenance_queued, 0, 1);
+}
+
+static DWORD __stdcall win32_update_thread_proc(void *data)
+{
+    f64 interval = UPDATE_THREAD_TICK_MS / 1000.0;
+    f64 next_start = win32_get_monotonic_seconds();
+    for (;;)
+    {
+        f64 now = win32_get_monotonic_seconds();
+        if (now < next_start)
+        {
+            Sleep((u32)((next_start - now)*1000.0) + 1);
+            continue;
+        }
+
+        UpdateCycle cycle;
+        begin_update_cycle(&cycle, next_start, win32_get_unix_seconds());
+
+        b32 polled = win32_update(&cycle);
+        next_start = end_update_cycle(&cycle, win32_get_monotonic_seconds(), interval);
+
+        // NOTE(dan): eviction and the index write happen in the background, once at a time
+        if (polled && atomic_compare_exchange_u32(&global_logo_cache_maintenance_queued, 1, 0) == 0)
+        {
+            win32_add_work(platform.low_priority_queue, win32_do_logo_cache_maintenance_work, &global_logo_cache);
+        }
+
+        win32_queue_logo_warmup(&global_logo_warmup);
+    }
+    return 0;
+}
+
+// NOTE(dan): the update thread keeps its own time, a timer message can't tell it that
+// the previous cycle is still running
+static void win32_init_update_thread(Win32State *state)
+{
+    HANDLE update_thread = CreateThread(0, 0, win32_update_thread_proc, 0, 0, 0);
+    if (update_thread)
+    {
+        CloseHandle(update_thread);
+    }
+}
+
+// NOTE(dan): without the ids nothing can be polled, so a failed query is retried a
+// few times with backoff before the tray icon shows up. after that the update
+// thread keeps retrying, the channels aren't given up on
+static void win32_query_user_ids()
+{
+    for (u32 attempt = 1; attempt <= USERS_QUERY_STARTUP_ATTEMPTS; ++attempt)
+    {
+        if (win32_try_query_user_ids())
+        {
+            break;
+        }
+
+        f64 now = win32_get_monotonic_seconds();
+        if (attempt < USERS_QUERY_STARTUP_ATTEMPTS && now < global_next_users_query)
+        {
+            Sleep((u32)((global_next_users_query - now)*1000.0));
+        }
     }
 }
 
@@ -765,10 +1591,23 @@ int __stdcall WinMain(HINSTANCE instance, HINSTANCE prev_instance, char *cmd_lin
 {
     Win32State *state = global_win32_state;
 
-    platform.show_notification = win32_show_notification;
+    win32_init_worker_pool(&global_worker_pool);
+    platform.high_priority_queue = &global_worker_pool.high_priority_queue;
+    platform.low_priority_queue = &global_worker_pool.low_priority_queue;
+    platform.add_work = win32_add_work;
+    platform.complete_all_work = win32_complete_all_work;
+    platform.complete_work_before = win32_complete_work_before;
+
+    platform.show_notifications = win32_show_notifications;
+    platform.signal_events = win32_signal_events;
     platform.load_file = win32_load_file;
     platform.unload_file = win32_unload_file;
+    platform.write_entire_file = win32_write_entire_file;
     platform.cache_logo = win32_cache_logo;
+    platform.map_file = win32_map_file;
+    platform.unmap_file = win32_unmap_file;
+    platform.flush_mapped_file = win32_flush_mapped_file;
+    platform.delete_file = win32_delete_file;
 
     state->window.class_name = "WhosAliveWindowClassName";
     state->window.title = "WhosAlive";
@@ -780,8 +1619,8 @@ int __stdcall WinMain(HINSTANCE instance, HINSTANCE prev_instance, char *cmd_lin
     MONITORINFO monitor_info = { sizeof(monitor_info) };
     GetMonitorInfo(monitor, &monitor_info);
 
-    state->overlay.width = 320;
-    state->overlay.height = 80;
+    state->overlay.width = CARD_WIDTH;
+    state->overlay.height = CARD_HEIGHT;
     state->overlay.x = monitor_info.rcWork.right - state->overlay.width - 20;
     state->overlay.y = monitor_info.rcWork.bottom - state->overlay.height - 20;
     state->overlay.style = WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOPMOST | WS_EX_TOOLWINDOW;
@@ -790,20 +1629,52 @@ int __stdcall WinMain(HINSTANCE instance, HINSTANCE prev_instance, char *cmd_lin
     state->overlay.popup = true;
     win32_init_window(&state->overlay);
 
-    global_overlay = win32_create_overlay(320, 80);
+    LARGE_INTEGER performance_frequency;
+    QueryPerformanceFrequency(&performance_frequency);
+    global_performance_frequency = performance_frequency.QuadPart;
+
+    init_animator(&global_animator, ANIMATION_DEFAULT_FPS);
+    init_render_kernels();
+    win32_bake_glyph_atlas(&global_glyph_atlas);
+    global_overlay = win32_create_overlay(CARD_WIDTH, CARD_STACK_MAX_HEIGHT);
+
+    void *card_cache_memory = win32_allocate(get_card_cache_memory_size(CARD_WIDTH, CARD_HEIGHT));
+    init_card_cache(&global_card_cache, card_cache_memory, CARD_WIDTH, CARD_HEIGHT, global_overlay.stride, get_default_card_theme());
     global_download_buffer = win32_allocate(MAX_DOWNLOAD_SIZE);
 
     win32_init_tray_icon(&state->window);
     win32_init_paths(state);
 
+    init_stream_snapshots(&stream_snapshots);
+    global_ui_snapshot_reader = register_snapshot_reader(&stream_snapshots);
+    ui_transition_consumer = register_transition_consumer(&transition_log);
+
     load_streams(state->streams_filename);
+    load_settings(state->settings_filename);
+    load_poll_models(state->poll_models_filename);
+    init_session_history(&session_history, state->history_path);
+    session_history.transition_consumer = register_transition_consumer(&transition_log);
+    for (u32 stream_index = 0; stream_index < num_streams; ++stream_index)
+    {
+        register_history_stream(&session_history, stream_index, streams[stream_index].name);
+    }
+    win32_init_logo_cache(&global_logo_cache);
     init_users_url(query_users_url_base, query_users_url);
 
     global_internet = InternetOpenA("WhosAlive", INTERNET_OPEN_TYPE_PRECONFIG, 0, 0, 0);
+    init_request_budget(&global_request_budget, win32_get_monotonic_seconds());
     assert(global_internet);
 
+    seed_poll_random((u32)win32_get_seconds());
     win32_query_user_ids();
-    init_streams_url(query_streams_url_base, query_streams_url);
+    load_stream_states(state->stream_states_filename, win32_get_unix_seconds());
+    init_stream_polls((u64)win32_get_monotonic_seconds());
+
+    // NOTE(dan): the update thread hands out the warm-up items, the list is ready before it starts
+    if (settings.logo_warmup)
+    {
+        win32_start_logo_warmup(&global_logo_warmup);
+    }
 
     win32_init_update_thread(state);
 
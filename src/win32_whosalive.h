@@ -39,6 +39,10 @@ struct Win32State
     u32 temp_path_length;
     char exe_filename[MAX_FILENAME_SIZE];
     char streams_filename[MAX_FILENAME_SIZE];
+    char settings_filename[MAX_FILENAME_SIZE];
+    char poll_models_filename[MAX_FILENAME_SIZE];
+    char stream_states_filename[MAX_FILENAME_SIZE];
+    char history_path[MAX_FILENAME_SIZE];
     char temp_path[MAX_FILENAME_SIZE];
 
     b32 quit_requested;
@@ -54,8 +58,75 @@ struct Win32Overlay
 
     HDC draw_dc;
     HBITMAP bitmap;
-    HFONT header_font;
-    HFONT message_font;
+};
+
+// NOTE(dan): every worker has its own ring in every queue. work added by a worker
+// goes to its own ring, other threads spread it around, and an idle worker steals
+// from the other rings. rings are bounded lock-free multi-producer multi-consumer
+#define MAX_WORKER_THREADS  16
+#define WORK_RING_SIZE      256 // NOTE(dan): has to be a power of two
+
+struct Win32WorkEntry
+{
+    PlatformWorkQueueCallback *callback;
+    void *data;
+};
+
+struct Win32WorkCell
+{
+    u32 volatile sequence;
+    Win32WorkEntry entry;
+};
+
+struct Win32WorkRing
+{
+    u32 volatile enqueue_position;
+    u8 padding0[60];
+    u32 volatile dequeue_position;
+    u8 padding1[60];
+
+    Win32WorkCell cells[WORK_RING_SIZE];
+};
+
+struct PlatformWorkQueue
+{
+    u32 volatile completion_goal;
+    u32 volatile completion_count;
+    u32 volatile next_ring;
+
+    u32 num_rings;
+    Win32WorkRing rings[MAX_WORKER_THREADS];
+};
+
+struct Win32WorkerPool
+{
+    HANDLE semaphore;
+    u32 tls_index;  // NOTE(dan): holds worker index + 1 on worker threads
+    u32 num_workers;
+
+    PlatformWorkQueue high_priority_queue;
+    PlatformWorkQueue low_priority_queue;
+};
+
+#define LOGO_WARMUP_MAX_JOBS 4
+
+struct Win32LogoWarmup;
+
+struct Win32LogoWarmupItem
+{
+    Win32LogoWarmup *warmup;
+    u32 logo_hash;
+    char url[512];
+};
+
+// NOTE(dan): only the update thread hands out items
+struct Win32LogoWarmup
+{
+    u32 next_item;
+    u32 num_items;
+    u32 max_jobs_in_flight;
+    u32 volatile jobs_in_flight;
+    Win32LogoWarmupItem items[MAX_STREAMS];
 };
 
 void win32_message_box(char *message, char *title);
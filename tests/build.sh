@@ -0,0 +1,23 @@
+#!/bin/sh
+# builds and runs the core tests, ./build.sh bench also runs the benchmarks.
+# UPDATE_GOLDEN=1 ./build.sh rewrites the golden images of card_test
+cd "$(dirname "$0")"
+
+cxx=${CXX:-g++}
+cplflags="-std=c++11 -O2 -g -DINTERNAL_BUILD=1 -fno-exceptions -fno-rtti -Wall -Wno-unused-function -Wno-unused-variable -Wno-write-strings -Wno-missing-braces -Wno-unused-but-set-variable -Wno-class-memaccess -Wno-format-truncation"
+
+mkdir -p ../build/tests
+
+failed=0
+for test in *_test.cpp; do
+    name=${test%.cpp}
+    if ! $cxx $cplflags $test -o ../build/tests/$name; then
+        echo "$name: build failed"
+        failed=1
+        continue
+    fi
+    if ! ../build/tests/$name "$@"; then
+        failed=1
+    fi
+done
+exit $failed
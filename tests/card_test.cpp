@@ -0,0 +1,202 @@
+// NOTE(dan): renders cards with a made-up font and logo and compares them to the
+// images in golden/. UPDATE_GOLDEN=1 writes the images instead, they are png files
+// of the premultiplied pixels. the renderer gives the same pixels for every kernel
+// set, so the same images are checked with the scalar kernels too
+#include "test.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ASSERT assert
+#define STBI_ONLY_PNG
+#include "../src/stb_image.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBIW_ASSERT assert
+#include "../src/stb_image_write.h"
+
+#define GOLDEN_PATH     "golden/"
+
+static void use_scalar_render_kernels()
+{
+    render_kernels.fill_row = fill_row_scalar;
+    render_kernels.blend_row = blend_row_scalar;
+    render_kernels.blend_row_constant_alpha = blend_row_constant_alpha_scalar;
+    render_kernels.blend_coverage_row = blend_coverage_row_scalar;
+    render_kernels.convert_row[1] = convert_gray_row_scalar;
+    render_kernels.convert_row[2] = convert_gray_alpha_row_scalar;
+    render_kernels.convert_row[3] = convert_rgb_row_scalar;
+    render_kernels.convert_row[4] = convert_rgba_row_scalar;
+}
+
+static void check_golden_image(char *name, Bitmap *bitmap)
+{
+    char filename[256];
+    snprintf(filename, array_count(filename), GOLDEN_PATH "%s.png", name);
+
+    u8 *rgba = (u8 *)malloc(bitmap->width * bitmap->height * 4);
+    for (i32 y = 0; y < bitmap->height; ++y)
+    {
+        for (i32 x = 0; x < bitmap->width; ++x)
+        {
+            u32 pixel = *get_pixel_pointer(bitmap, x, y);
+            u8 *out = rgba + (y*bitmap->width + x)*4;
+            out[0] = (u8)(pixel >> 16);
+            out[1] = (u8)(pixel >> 8);
+            out[2] = (u8)(pixel >> 0);
+            out[3] = (u8)(pixel >> 24);
+        }
+    }
+
+    char *update = getenv("UPDATE_GOLDEN");
+    if (update && update[0] == '1')
+    {
+        b32 written = stbi_write_png(filename, bitmap->width, bitmap->height, 4, rgba, bitmap->width * 4) != 0;
+        check(written);
+        printf("wrote %s\n", filename);
+    }
+    else
+    {
+        int width, height, channels;
+        u8 *golden = stbi_load(filename, &width, &height, &channels, 4);
+        check(golden != 0);
+        if (golden)
+        {
+            check(width == bitmap->width && height == bitmap->height);
+            if (width == bitmap->width && height == bitmap->height)
+            {
+                u32 num_different = 0;
+                for (i32 byte_index = 0; byte_index < width * height * 4; ++byte_index)
+                {
+                    num_different += (golden[byte_index] != rgba[byte_index]);
+                }
+                if (num_different)
+                {
+                    printf("%s: %u bytes differ\n", filename, num_different);
+                }
+                check(num_different == 0);
+            }
+            stbi_image_free(golden);
+        }
+    }
+    free(rgba);
+}
+
+static void render_test_cards(CardCache *cache, Logo *logo)
+{
+    // NOTE(dan): bottom-up like the win32 DIB
+    static u32 card_pixels[CARD_WIDTH * CARD_HEIGHT];
+    Bitmap card;
+    card.width = CARD_WIDTH;
+    card.height = CARD_HEIGHT;
+    card.pitch = -CARD_WIDTH * 4;
+    card.memory = (u8 *)(card_pixels + (CARD_HEIGHT - 1) * CARD_WIDTH);
+
+    card_cache_render(cache, &card, &test_atlas, "somebody started streaming", "Playing: Some Game", 1, logo);
+    check_golden_image("card_logo", &card);
+
+    // NOTE(dan): the cached copy has to be the same card
+    b32 copied = card_cache_copy(cache, &card, "somebody started streaming", "Playing: Some Game", 1);
+    check(copied);
+    check_golden_image("card_logo", &card);
+
+    card_cache_render(cache, &card, &test_atlas, "nologo started streaming", "Playing: Nothing", 2, 0);
+    check_golden_image("card_no_logo", &card);
+
+    card_cache_render(cache, &card, &test_atlas,
+                      "a_channel_with_a_really_long_name_that_wont_fit started streaming",
+                      "Playing: a game whose name is far too long for one card line to hold", 3, logo);
+    check_golden_image("card_clipped", &card);
+
+    // NOTE(dan): a stack with gaps, as the overlay shows it
+    static u32 stack_pixels[CARD_WIDTH * CARD_STACK_MAX_HEIGHT];
+    Bitmap surface;
+    surface.width = CARD_WIDTH;
+    surface.height = CARD_STACK_MAX_HEIGHT;
+    surface.pitch = -CARD_WIDTH * 4;
+    surface.memory = (u8 *)(stack_pixels + (CARD_STACK_MAX_HEIGHT - 1) * CARD_WIDTH);
+
+    CardStack stack = {};
+    Notification notifications[3] = {};
+    for (u32 notification_index = 0; notification_index < array_count(notifications); ++notification_index)
+    {
+        Notification *notification = notifications + notification_index;
+        snprintf(notification->title, array_count(notification->title), "channel%u started streaming", notification_index);
+        snprintf(notification->message, array_count(notification->message), "Playing: game %u", notification_index);
+        notification->logo_hash = 10 + notification_index;
+    }
+    push_notifications(&stack, notifications, array_count(notifications));
+
+    for (u32 card_index = 0; card_index < stack.num_cards; ++card_index)
+    {
+        Bitmap card_bitmap = get_stacked_card_bitmap(&surface, card_index);
+        card_cache_render(cache, &card_bitmap, &test_atlas, stack.cards[card_index].title, stack.cards[card_index].message,
+                          stack.cards[card_index].logo_hash, (card_index == 1) ? 0 : logo);
+    }
+    clear_card_stack_gaps(&surface, &stack);
+
+    surface.height = get_card_stack_height(&stack);
+    check_golden_image("card_stack", &surface);
+}
+
+static void benchmark_card_render(CardCache *cache, Logo *logo)
+{
+    static u32 card_pixels[CARD_WIDTH * CARD_HEIGHT];
+    Bitmap card;
+    card.width = CARD_WIDTH;
+    card.height = CARD_HEIGHT;
+    card.pitch = -CARD_WIDTH * 4;
+    card.memory = (u8 *)(card_pixels + (CARD_HEIGHT - 1) * CARD_WIDTH);
+
+    u32 iterations = 20000;
+
+    // NOTE(dan): text layouts stay cached, every card is drawn from the template up
+    f64 start = get_test_seconds();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+    {
+        copy_bitmap(&card, &cache->card_template);
+        render_card_content(&card, &test_atlas, &cache->theme, "somebody started streaming", "Playing: Some Game", logo);
+    }
+    f64 render_seconds = get_test_seconds() - start;
+
+    start = get_test_seconds();
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+    {
+        card_cache_copy(cache, &card, "somebody started streaming", "Playing: Some Game", 1);
+    }
+    f64 copy_seconds = get_test_seconds() - start;
+
+    printf("card render: %.2f us per card, cached copy: %.2f us per card\n",
+           render_seconds*1e6 / iterations, copy_seconds*1e6 / iterations);
+}
+
+int main(int argc, char **argv)
+{
+    init_test_platform();
+    bake_test_font(&test_atlas, FontId_Header, 18, 14);
+    bake_test_font(&test_atlas, FontId_Message, 16, 12);
+
+    static u8 logo_file[TEST_LOGO_FILE_SIZE];
+    Logo logo;
+
+    u32 cache_memory_size = get_card_cache_memory_size(CARD_WIDTH, CARD_HEIGHT);
+    void *cache_memory = malloc(cache_memory_size);
+    static CardCache cache;
+
+    use_scalar_render_kernels();
+    make_test_logo(logo_file, &logo);
+    init_card_cache(&cache, cache_memory, CARD_WIDTH, CARD_HEIGHT, -CARD_WIDTH * 4, get_default_card_theme());
+    render_test_cards(&cache, &logo);
+
+    init_render_kernels();
+    make_test_logo(logo_file, &logo);
+    cache = {};
+    init_card_cache(&cache, cache_memory, CARD_WIDTH, CARD_HEIGHT, -CARD_WIDTH * 4, get_default_card_theme());
+    render_test_cards(&cache, &logo);
+
+    if (benchmarks_requested(argc, argv))
+    {
+        benchmark_card_render(&cache, &logo);
+    }
+
+    free(cache_memory);
+    return end_test("card_test");
+}
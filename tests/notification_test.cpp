@@ -0,0 +1,145 @@
+// NOTE(dan): a burst of go-live events becomes one stack of cards. the benchmark
+// times a 30-channel burst from the events to the drawn surface, like
+// win32_create_overlay_graphics does it. the present is a win32 call and isn't timed here
+#include "test.h"
+
+#define BURST_SIZE  30
+
+static char *test_logo_path = "/tmp/whosalive_notification_test.logo";
+
+static void make_test_notifications(Notification *notifications, u32 count, u32 first)
+{
+    for (u32 notification_index = 0; notification_index < count; ++notification_index)
+    {
+        Notification *notification = notifications + notification_index;
+        snprintf(notification->title, array_count(notification->title), "channel%u started streaming", first + notification_index);
+        snprintf(notification->message, array_count(notification->message), "Playing: game %u", first + notification_index);
+        notification->logo_hash = 1 + first + notification_index;
+    }
+}
+
+static void check_card_stack()
+{
+    Notification notifications[BURST_SIZE];
+    CardStack stack = {};
+
+    make_test_notifications(notifications, 3, 0);
+    push_notifications(&stack, notifications, 3);
+    check(stack.num_cards == 3);
+    check(get_card_stack_height(&stack) == 3*CARD_HEIGHT + 2*CARD_STACK_GAP);
+
+    // NOTE(dan): the oldest card makes room, the rest stay in order
+    make_test_notifications(notifications, 3, 3);
+    push_notifications(&stack, notifications, 3);
+    check(stack.num_cards == CARD_STACK_MAX_CARDS);
+    check(strings_equal(stack.cards[0].title, "channel1 started streaming"));
+    check(strings_equal(stack.cards[4].title, "channel5 started streaming"));
+
+    // NOTE(dan): a burst as big as the stack fits without a summary
+    make_test_notifications(notifications, CARD_STACK_MAX_CARDS, 10);
+    push_notifications(&stack, notifications, CARD_STACK_MAX_CARDS);
+    check(stack.num_cards == CARD_STACK_MAX_CARDS);
+    check(strings_equal(stack.cards[4].title, "channel14 started streaming"));
+
+    make_test_notifications(notifications, BURST_SIZE, 20);
+    push_notifications(&stack, notifications, BURST_SIZE);
+    check(stack.num_cards == CARD_STACK_MAX_CARDS);
+    check(strings_equal(stack.cards[0].title, "channel20 started streaming"));
+    check(strings_equal(stack.cards[3].title, "channel23 started streaming"));
+    check(strings_equal(stack.cards[4].title, "26 more started streaming"));
+    check(stack.cards[4].logo_hash == 0);
+    check(get_card_stack_height(&stack) == CARD_STACK_MAX_HEIGHT);
+}
+
+static void render_card(CardCache *cache, Bitmap *card_bitmap, Notification *card)
+{
+    begin_card_cache(cache);
+    if (!card_cache_copy(cache, card_bitmap, card->title, card->message, card->logo_hash))
+    {
+        LoadedFile logo_file = platform.load_file(test_logo_path);
+        Logo logo;
+        b32 has_logo = card->logo_hash && parse_logo_file(logo_file.contents, logo_file.size, &logo);
+
+        card_cache_render(cache, card_bitmap, &test_atlas, card->title, card->message, card->logo_hash, has_logo ? &logo : 0);
+
+        platform.unload_file(logo_file);
+    }
+    end_card_cache(cache);
+}
+
+static void show_burst(CardCache *cache, CardStack *stack, Bitmap *surface, Notification *notifications, u32 count)
+{
+    push_notifications(stack, notifications, count);
+
+    for (u32 card_index = 0; card_index < stack->num_cards; ++card_index)
+    {
+        Bitmap card_bitmap = get_stacked_card_bitmap(surface, card_index);
+        render_card(cache, &card_bitmap, stack->cards + card_index);
+    }
+    clear_card_stack_gaps(surface, stack);
+}
+
+static void benchmark_burst()
+{
+    static u8 logo_file[TEST_LOGO_FILE_SIZE];
+    Logo logo;
+    make_test_logo(logo_file, &logo);
+    b32 written = platform.write_entire_file(test_logo_path, logo_file, TEST_LOGO_FILE_SIZE);
+    check(written);
+
+    static u32 surface_pixels[CARD_WIDTH * CARD_STACK_MAX_HEIGHT];
+    Bitmap surface;
+    surface.width = CARD_WIDTH;
+    surface.height = CARD_STACK_MAX_HEIGHT;
+    surface.pitch = -CARD_WIDTH * 4;
+    surface.memory = (u8 *)(surface_pixels + (CARD_STACK_MAX_HEIGHT - 1) * CARD_WIDTH);
+
+    Notification notifications[BURST_SIZE];
+    make_test_notifications(notifications, BURST_SIZE, 0);
+
+    void *cache_memory = malloc(get_card_cache_memory_size(CARD_WIDTH, CARD_HEIGHT));
+    static CardCache cache;
+
+    u32 iterations = 200;
+    f64 cold_seconds = 0.0;
+    f64 warm_seconds = 0.0;
+    for (u32 iteration = 0; iteration < iterations; ++iteration)
+    {
+        // NOTE(dan): nothing cached, every card is laid out and drawn
+        memset(&cache, 0, sizeof(cache));
+        memset(&test_atlas.layout_cache, 0, sizeof(test_atlas.layout_cache));
+        init_card_cache(&cache, cache_memory, CARD_WIDTH, CARD_HEIGHT, -CARD_WIDTH * 4, get_default_card_theme());
+
+        CardStack stack = {};
+        f64 start = get_test_seconds();
+        show_burst(&cache, &stack, &surface, notifications, BURST_SIZE);
+        cold_seconds += get_test_seconds() - start;
+
+        start = get_test_seconds();
+        show_burst(&cache, &stack, &surface, notifications, BURST_SIZE);
+        warm_seconds += get_test_seconds() - start;
+    }
+
+    printf("%u-channel burst: %.1f us with a cold card cache, %.1f us with a warm one\n",
+           BURST_SIZE, cold_seconds*1e6 / iterations, warm_seconds*1e6 / iterations);
+
+    free(cache_memory);
+    platform.delete_file(test_logo_path);
+}
+
+int main(int argc, char **argv)
+{
+    init_test_platform();
+    init_render_kernels();
+    bake_test_font(&test_atlas, FontId_Header, 18, 14);
+    bake_test_font(&test_atlas, FontId_Message, 16, 12);
+
+    check_card_stack();
+
+    if (benchmarks_requested(argc, argv))
+    {
+        benchmark_burst();
+    }
+
+    return end_test("notification_test");
+}
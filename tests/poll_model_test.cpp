@@ -0,0 +1,158 @@
+// NOTE(dan): channels that each usually go live at their own time of day, on most
+// days of the week. all of them share the streams request, so what counts is how
+// many requests go out, not how often each channel is polled. a week of adaptive
+// intervals is compared with polling everything on the base interval, in requests
+// and in how late go-lives are seen. the models learn from the four weeks before
+#include "test.h"
+
+#define TEST_BASE_INTERVAL  POLL_DEFAULT_INTERVAL_SECS
+#define TEST_DAY_SECS       (24 * 60 * 60)
+#define TEST_LEARN_DAYS     28
+#define TEST_DAYS           (TEST_LEARN_DAYS + 7)
+#define TEST_FIRST_DAY      19600   // NOTE(dan): somewhere in 2023, any day works
+
+struct TestChannel
+{
+    PollModel model;
+    u64 session_starts[TEST_DAYS];  // NOTE(dan): 0 on days it doesn't stream
+    u64 session_ends[TEST_DAYS];
+
+    u64 deadline;
+    b32 online;
+};
+
+struct PollSimulation
+{
+    u64 num_requests;
+    u64 num_polls;
+    u64 num_go_lives;
+    u64 total_delay;
+};
+
+static TestChannel test_channels[MAX_STREAMS];
+
+static void make_test_channels(u32 num_channels, u32 *random_state)
+{
+    for (u32 channel_index = 0; channel_index < num_channels; ++channel_index)
+    {
+        TestChannel *channel = test_channels + channel_index;
+        memset(channel, 0, sizeof(*channel));
+
+        u32 start_secs = (next_test_random(random_state) % 96) * 15 * 60;
+        u32 length_secs = (2 + next_test_random(random_state) % 4) * 60 * 60;
+        u32 days_off = (1 << (next_test_random(random_state) % 7)) | (1 << (next_test_random(random_state) % 7));
+
+        for (u32 day_index = 0; day_index < TEST_DAYS; ++day_index)
+        {
+            u64 day = TEST_FIRST_DAY + day_index;
+            if (!((days_off >> (day % 7)) & 1))
+            {
+                // NOTE(dan): up to half an hour late
+                u64 start = day*TEST_DAY_SECS + start_secs + next_test_random(random_state) % (30 * 60);
+                channel->session_starts[day_index] = start;
+                channel->session_ends[day_index] = start + length_secs;
+                if (day_index < TEST_LEARN_DAYS)
+                {
+                    record_go_live(&channel->model, start);
+                }
+            }
+        }
+    }
+}
+
+// NOTE(dan): the start of the session live at the time, 0 when offline. sessions can run past midnight
+static u64 get_test_session_start(TestChannel *channel, u64 time)
+{
+    u64 start = 0;
+    u32 day_index = (u32)(time / TEST_DAY_SECS - TEST_FIRST_DAY);
+    for (u32 offset = 0; offset < 2 && offset <= day_index; ++offset)
+    {
+        u64 session_start = channel->session_starts[day_index - offset];
+        if (session_start && time >= session_start && time < channel->session_ends[day_index - offset])
+        {
+            start = session_start;
+        }
+    }
+    return start;
+}
+
+static PollSimulation simulate_week(u32 num_channels, b32 adaptive)
+{
+    PollSimulation simulation = {};
+
+    u64 first_second = (u64)(TEST_FIRST_DAY + TEST_LEARN_DAYS)*TEST_DAY_SECS;
+    for (u32 channel_index = 0; channel_index < num_channels; ++channel_index)
+    {
+        TestChannel *channel = test_channels + channel_index;
+        channel->deadline = first_second;
+        channel->online = (get_test_session_start(channel, first_second) != 0);
+    }
+
+    for (u64 now = first_second; now < first_second + 7*TEST_DAY_SECS; ++now)
+    {
+        b32 requested = false;
+        for (u32 channel_index = 0; channel_index < num_channels; ++channel_index)
+        {
+            TestChannel *channel = test_channels + channel_index;
+            if (channel->deadline != now)
+            {
+                continue;
+            }
+
+            requested = true;
+            ++simulation.num_polls;
+
+            u64 session_start = get_test_session_start(channel, now);
+            b32 online = (session_start != 0);
+            if (online && !channel->online)
+            {
+                ++simulation.num_go_lives;
+                simulation.total_delay += now - session_start;
+            }
+            channel->online = online;
+
+            // NOTE(dan): the same choice end_poll_batch makes
+            u32 interval = TEST_BASE_INTERVAL;
+            if (adaptive && !online)
+            {
+                interval = get_adaptive_poll_interval(&channel->model, now, TEST_BASE_INTERVAL);
+            }
+            channel->deadline = ((now / interval) + 1) * interval;
+        }
+        simulation.num_requests += requested;
+    }
+    return simulation;
+}
+
+static void compare_poll_intervals(u32 num_channels)
+{
+    u32 random_state = 31337 + num_channels;
+    make_test_channels(num_channels, &random_state);
+
+    PollSimulation fixed = simulate_week(num_channels, false);
+    PollSimulation adaptive = simulate_week(num_channels, true);
+
+    printf("%2u channels, base interval: %5llu requests, %6llu channel polls, go-lives seen %3.0f s late\n",
+           num_channels, (unsigned long long)fixed.num_requests, (unsigned long long)fixed.num_polls,
+           (f64)fixed.total_delay / (f64)fixed.num_go_lives);
+    printf("%2u channels, adaptive:      %5llu requests, %6llu channel polls, go-lives seen %3.0f s late\n",
+           num_channels, (unsigned long long)adaptive.num_requests, (unsigned long long)adaptive.num_polls,
+           (f64)adaptive.total_delay / (f64)adaptive.num_go_lives);
+
+    // NOTE(dan): the adaptive intervals never send more requests than the base interval
+    check(fixed.num_go_lives > 0);
+    check(adaptive.num_go_lives == fixed.num_go_lives);
+    check(adaptive.num_requests <= fixed.num_requests);
+    check(adaptive.num_polls < fixed.num_polls);
+}
+
+int main(int argc, char **argv)
+{
+    init_test_platform();
+
+    compare_poll_intervals(1);
+    compare_poll_intervals(8);
+    compare_poll_intervals(MAX_STREAMS);
+
+    return end_test("poll_model_test");
+}
@@ -0,0 +1,191 @@
+// NOTE(dan): random schedules, unschedules and clock jumps against a plain array of
+// deadlines. a channel must come out exactly on the first advance that reaches its
+// deadline, never before and never after
+#include "test.h"
+
+#define NUM_TEST_TIMERS     512
+#define NUM_TEST_STEPS      20000
+
+static u64 random_test_delay(u32 *random_state)
+{
+    u32 random = next_test_random(random_state);
+    u64 delay = 0;
+    switch (random & 7)
+    {
+        case 0: delay = 0; break;
+        case 1: delay = (random >> 8) % 64; break;
+        case 2: delay = (random >> 8) % 4096; break;
+        case 3: delay = (random >> 8) % (1 << 20); break;
+        case 4: delay = POLL_WHEEL_MAX_DELAY + (random >> 8); break;
+        default: delay = 30 + (random >> 8) % 300; break;
+    }
+    return delay;
+}
+
+static void check_against_brute_force()
+{
+    static PollTimer timers[NUM_TEST_TIMERS];
+    static u64 deadlines[NUM_TEST_TIMERS];
+    static b32 scheduled[NUM_TEST_TIMERS];
+    u32 due[NUM_TEST_TIMERS];
+
+    PollScheduler scheduler;
+    u64 now = 1000;
+    init_poll_scheduler(&scheduler, timers, NUM_TEST_TIMERS, now);
+
+    u32 random_state = 12345;
+    u32 num_early = 0;
+    u32 num_late = 0;
+    u32 num_out_of_order = 0;
+    u32 num_polls = 0;
+
+    for (u32 step = 0; step < NUM_TEST_STEPS; ++step)
+    {
+        u32 num_changes = next_test_random(&random_state) % 8;
+        for (u32 change = 0; change < num_changes; ++change)
+        {
+            u32 timer_index = next_test_random(&random_state) % NUM_TEST_TIMERS;
+            if (next_test_random(&random_state) % 4)
+            {
+                u64 deadline = now + random_test_delay(&random_state);
+                if (deadline > now + POLL_WHEEL_MAX_DELAY)
+                {
+                    deadline = now + POLL_WHEEL_MAX_DELAY;
+                }
+                schedule_poll(&scheduler, timer_index, deadline);
+                deadlines[timer_index] = deadline;
+                scheduled[timer_index] = true;
+            }
+            else
+            {
+                unschedule_poll(&scheduler, timer_index);
+                scheduled[timer_index] = false;
+            }
+        }
+
+        // NOTE(dan): mostly one tick, sometimes a long jump like after the machine slept
+        u32 random = next_test_random(&random_state);
+        now += ((random & 63) == 0) ? (random >> 8) % 200000 : 1 + (random >> 8) % 3;
+        advance_poll_scheduler(&scheduler, now);
+
+        u32 num_expected = 0;
+        for (u32 timer_index = 0; timer_index < NUM_TEST_TIMERS; ++timer_index)
+        {
+            num_expected += (scheduled[timer_index] && deadlines[timer_index] <= now);
+        }
+        check(scheduler.num_due == num_expected);
+
+        u32 num_taken = take_due_polls(&scheduler, due, NUM_TEST_TIMERS);
+        u64 last_deadline = 0;
+        for (u32 taken_index = 0; taken_index < num_taken; ++taken_index)
+        {
+            u32 timer_index = due[taken_index];
+            num_early += (!scheduled[timer_index] || deadlines[timer_index] > now);
+            num_out_of_order += (deadlines[timer_index] < last_deadline);
+            last_deadline = deadlines[timer_index];
+            scheduled[timer_index] = false;
+        }
+        num_polls += num_taken;
+
+        for (u32 timer_index = 0; timer_index < NUM_TEST_TIMERS; ++timer_index)
+        {
+            num_late += (scheduled[timer_index] && deadlines[timer_index] <= now);
+        }
+    }
+
+    printf("%u polls in %u steps, %u early, %u late, %u out of order\n", num_polls, NUM_TEST_STEPS, num_early, num_late, num_out_of_order);
+    check(num_polls > NUM_TEST_STEPS);
+    check(num_early == 0);
+    check(num_late == 0);
+    check(num_out_of_order == 0);
+}
+
+static void check_batches()
+{
+    PollTimer timers[10];
+    PollScheduler scheduler;
+    init_poll_scheduler(&scheduler, timers, array_count(timers), 0);
+
+    // NOTE(dan): 3 and 7 are due together, every channel comes out in the order it got due
+    u64 deadlines[10] = {5, 9, 70, 3, 5000, 8, 1, 3, 100, 2};
+    for (u32 timer_index = 0; timer_index < array_count(timers); ++timer_index)
+    {
+        schedule_poll(&scheduler, timer_index, deadlines[timer_index]);
+    }
+    check(scheduler.num_due == 0);
+
+    u32 due[10];
+    advance_poll_scheduler(&scheduler, 5);
+    check(scheduler.num_due == 5);
+
+    u32 num_taken = take_due_polls(&scheduler, due, 4);
+    check(num_taken == 4);
+    check(scheduler.num_due == 1);
+    check(due[0] == 6 && due[1] == 9);
+    check(deadlines[due[2]] == 3 && deadlines[due[3]] == 3);
+
+    // NOTE(dan): a due channel can still be taken out
+    unschedule_poll(&scheduler, 0);
+    check(scheduler.num_due == 0);
+    num_taken = take_due_polls(&scheduler, due, 4);
+    check(num_taken == 0);
+
+    advance_poll_scheduler(&scheduler, 10000);
+    num_taken = take_due_polls(&scheduler, due, 10);
+    check(num_taken == 5);
+    check(due[0] == 5 && due[1] == 1 && due[2] == 2 && due[3] == 8 && due[4] == 4);
+}
+
+static void benchmark_many_channels()
+{
+    u32 num_channels = 100000;
+    PollTimer *timers = (PollTimer *)malloc(num_channels * sizeof(PollTimer));
+    u32 *due = (u32 *)malloc(num_channels * sizeof(u32));
+
+    PollScheduler scheduler;
+    u64 now = 0;
+    init_poll_scheduler(&scheduler, timers, num_channels, now);
+
+    u32 random_state = 7;
+    for (u32 timer_index = 0; timer_index < num_channels; ++timer_index)
+    {
+        schedule_poll(&scheduler, timer_index, 1 + next_test_random(&random_state) % 300);
+    }
+
+    // NOTE(dan): a day of one second ticks, every poll sets the next one 1-5 minutes out
+    u64 num_ticks = 24*60*60;
+    u64 num_polls = 0;
+    f64 start = get_test_seconds();
+    for (u64 tick = 0; tick < num_ticks; ++tick)
+    {
+        advance_poll_scheduler(&scheduler, ++now);
+        u32 num_taken = take_due_polls(&scheduler, due, num_channels);
+        for (u32 taken_index = 0; taken_index < num_taken; ++taken_index)
+        {
+            schedule_poll(&scheduler, due[taken_index], now + 60 + next_test_random(&random_state) % 240);
+        }
+        num_polls += num_taken;
+    }
+    f64 seconds = get_test_seconds() - start;
+
+    printf("%u channels: %.1f ns per poll, %.2f us per tick, %.0f polls per tick\n", num_channels,
+           seconds*1e9 / (f64)num_polls, seconds*1e6 / (f64)num_ticks, (f64)num_polls / (f64)num_ticks);
+
+    free(due);
+    free(timers);
+}
+
+int main(int argc, char **argv)
+{
+    init_test_platform();
+
+    check_against_brute_force();
+    check_batches();
+
+    if (benchmarks_requested(argc, argv))
+    {
+        benchmark_many_channels();
+    }
+
+    return end_test("poll_scheduler_test");
+}
@@ -0,0 +1,240 @@
+// NOTE(dan): every row kernel against its scalar version on random rows of every
+// length up to a few vectors, so the tails and unaligned starts are covered too.
+// the benchmark gives pixels per nanosecond over one card and over the full stack
+#include "test.h"
+
+#define MAX_TEST_ROW        67
+#define NUM_TEST_ROWS       2000
+
+struct TestKernelSet
+{
+    char *name;
+    b32 supported;
+    RenderKernels kernels;
+};
+
+inline u32 random_premultiplied_pixel(u32 *random_state)
+{
+    u32 random = next_test_random(random_state);
+    u32 alpha = random & 0xFF;
+
+    // NOTE(dan): mostly see-through and solid pixels, those take their own paths in the kernels
+    switch ((random >> 8) & 3)
+    {
+        case 0: alpha = 0; break;
+        case 1: alpha = 255; break;
+    }
+
+    u32 pixel = alpha << 24;
+    for (u32 shift = 0; shift < 24; shift += 8)
+    {
+        u32 channel = alpha ? (next_test_random(random_state) % (alpha + 1)) : 0;
+        pixel |= channel << shift;
+    }
+    return pixel;
+}
+
+static void fill_random_pixels(u32 *pixels, i32 count, u32 *random_state)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        pixels[x] = random_premultiplied_pixel(random_state);
+    }
+}
+
+static void fill_random_bytes(u8 *bytes, i32 count, u32 *random_state)
+{
+    for (i32 x = 0; x < count; ++x)
+    {
+        u32 random = next_test_random(random_state);
+        bytes[x] = (u8)(((random >> 8) & 3) == 0 ? 0 : ((random >> 8) & 3) == 1 ? 255 : random);
+    }
+}
+
+static void check_kernels_match(TestKernelSet *set, RenderKernels *scalar)
+{
+    u32 random_state = 0x9E3779B9;
+
+    // NOTE(dan): one past the row on either side catches writes out of bounds
+    u32 expected[MAX_TEST_ROW + 2];
+    u32 actual[MAX_TEST_ROW + 2];
+    u32 src[MAX_TEST_ROW];
+    u8 bytes[MAX_TEST_ROW * 4];
+
+    u32 num_mismatches = 0;
+    for (u32 row_index = 0; row_index < NUM_TEST_ROWS; ++row_index)
+    {
+        i32 count = (i32)(row_index % (MAX_TEST_ROW + 1));
+        u32 color = random_premultiplied_pixel(&random_state);
+        u32 alpha = next_test_random(&random_state) & 0xFF;
+
+        fill_random_pixels(expected, count + 2, &random_state);
+        fill_random_pixels(src, count, &random_state);
+        fill_random_bytes(bytes, count * 4, &random_state);
+
+        for (u32 kernel_index = 0; kernel_index < 8; ++kernel_index)
+        {
+            fill_random_pixels(expected, count + 2, &random_state);
+            memcpy(actual, expected, sizeof(expected));
+
+            switch (kernel_index)
+            {
+                case 0:
+                {
+                    scalar->fill_row(expected + 1, color, count);
+                    set->kernels.fill_row(actual + 1, color, count);
+                } break;
+
+                case 1:
+                {
+                    scalar->blend_row(expected + 1, src, count);
+                    set->kernels.blend_row(actual + 1, src, count);
+                } break;
+
+                case 2:
+                {
+                    scalar->blend_row_constant_alpha(expected + 1, src, count, alpha);
+                    set->kernels.blend_row_constant_alpha(actual + 1, src, count, alpha);
+                } break;
+
+                case 3:
+                {
+                    scalar->blend_coverage_row(expected + 1, bytes, count, color);
+                    set->kernels.blend_coverage_row(actual + 1, bytes, count, color);
+                } break;
+
+                default:
+                {
+                    u32 channels = kernel_index - 3;
+                    scalar->convert_row[channels](expected + 1, bytes, count);
+                    set->kernels.convert_row[channels](actual + 1, bytes, count);
+                } break;
+            }
+
+            if (memcmp(expected, actual, sizeof(expected)) != 0)
+            {
+                if (num_mismatches++ == 0)
+                {
+                    printf("%s: kernel %u differs from scalar on a row of %d pixels\n", set->name, kernel_index, count);
+                }
+            }
+        }
+    }
+    check(num_mismatches == 0);
+}
+
+static void benchmark_kernels(TestKernelSet *set, i32 width, i32 height)
+{
+    i32 num_pixels = width * height;
+    u32 *dest = (u32 *)malloc(num_pixels * sizeof(u32));
+    u32 *src = (u32 *)malloc(num_pixels * sizeof(u32));
+    u8 *coverage = (u8 *)malloc(num_pixels);
+
+    u32 random_state = 1;
+    fill_random_pixels(src, num_pixels, &random_state);
+    fill_random_bytes(coverage, num_pixels, &random_state);
+
+    u32 iterations = 2000;
+    f64 seconds[4];
+    for (u32 kernel_index = 0; kernel_index < 4; ++kernel_index)
+    {
+        memset(dest, 0, num_pixels * sizeof(u32));
+
+        f64 start = get_test_seconds();
+        for (u32 iteration = 0; iteration < iterations; ++iteration)
+        {
+            for (i32 y = 0; y < height; ++y)
+            {
+                u32 *dest_row = dest + y*width;
+                switch (kernel_index)
+                {
+                    case 0: set->kernels.fill_row(dest_row, 0xFFFFFFFF, width); break;
+                    case 1: set->kernels.blend_row(dest_row, src + y*width, width); break;
+                    case 2: set->kernels.blend_row_constant_alpha(dest_row, src + y*width, width, 0xC0); break;
+                    case 3: set->kernels.blend_coverage_row(dest_row, coverage + y*width, width, 0xFF404040); break;
+                }
+            }
+        }
+        seconds[kernel_index] = get_test_seconds() - start;
+    }
+
+    f64 total_pixels = (f64)num_pixels * iterations;
+    printf("%-6s %dx%d px/ns: fill %.2f, blend %.2f, blend alpha %.2f, coverage %.2f\n", set->name, width, height,
+           total_pixels / (seconds[0]*1e9), total_pixels / (seconds[1]*1e9),
+           total_pixels / (seconds[2]*1e9), total_pixels / (seconds[3]*1e9));
+
+    free(coverage);
+    free(src);
+    free(dest);
+}
+
+int main(int argc, char **argv)
+{
+    init_test_platform();
+
+    RenderKernels scalar =
+    {
+        fill_row_scalar,
+        blend_row_scalar,
+        blend_row_constant_alpha_scalar,
+        blend_coverage_row_scalar,
+        {
+            0,
+            convert_gray_row_scalar,
+            convert_gray_alpha_row_scalar,
+            convert_rgb_row_scalar,
+            convert_rgba_row_scalar,
+        },
+    };
+
+    TestKernelSet sets[4];
+    sets[0].name = "scalar";
+    sets[0].supported = true;
+    sets[0].kernels = scalar;
+
+    // NOTE(dan): the defaults before init_render_kernels
+    sets[1].name = "sse2";
+    sets[1].supported = true;
+    sets[1].kernels = render_kernels;
+
+    sets[2].name = "ssse3";
+    sets[2].supported = cpu_supports_ssse3();
+    sets[2].kernels = render_kernels;
+    sets[2].kernels.convert_row[1] = convert_gray_row_ssse3;
+    sets[2].kernels.convert_row[3] = convert_rgb_row_ssse3;
+    sets[2].kernels.convert_row[4] = convert_rgba_row_ssse3;
+
+    sets[3].name = "avx2";
+    sets[3].supported = cpu_supports_avx2();
+    sets[3].kernels = sets[2].kernels;
+    sets[3].kernels.fill_row = fill_row_avx2;
+    sets[3].kernels.blend_row = blend_row_avx2;
+    sets[3].kernels.blend_row_constant_alpha = blend_row_constant_alpha_avx2;
+
+    for (u32 set_index = 1; set_index < array_count(sets); ++set_index)
+    {
+        TestKernelSet *set = sets + set_index;
+        if (set->supported)
+        {
+            check_kernels_match(set, &scalar);
+        }
+        else
+        {
+            printf("%s: not supported by this cpu, skipped\n", set->name);
+        }
+    }
+
+    if (benchmarks_requested(argc, argv))
+    {
+        for (u32 set_index = 0; set_index < array_count(sets); ++set_index)
+        {
+            if (sets[set_index].supported)
+            {
+                benchmark_kernels(sets + set_index, CARD_WIDTH, CARD_HEIGHT);
+                benchmark_kernels(sets + set_index, CARD_WIDTH, CARD_STACK_MAX_HEIGHT);
+            }
+        }
+    }
+
+    return end_test("render_test");
+}
@@ -0,0 +1,326 @@
+// NOTE(dan): session lookups against a plain list of every session, the jump
+// pointers have to keep them to O(log n) records. then a crash before a flush and a
+// history long enough to be compacted, both in a scratch directory
+#include "test.h"
+
+#define TEST_HISTORY_PATH   "/tmp/whosalive_session_history_test/"
+#define NUM_TEST_STREAMS    3
+
+struct TestSession
+{
+    u64 start;
+    u64 end;
+};
+
+struct TestSessions
+{
+    u32 count;
+    TestSession *sessions;
+};
+
+static TransitionLog test_log;
+static TestSessions test_sessions[NUM_TEST_STREAMS];
+static char *test_stream_names[NUM_TEST_STREAMS] = {"first", "second", "third"};
+
+static void reset_history_directory()
+{
+    int result = system("rm -rf " TEST_HISTORY_PATH " && mkdir -p " TEST_HISTORY_PATH);
+    check(result == 0);
+}
+
+static void open_test_history(SessionHistory *history)
+{
+    memset(history, 0, sizeof(*history));
+    init_session_history(history, TEST_HISTORY_PATH);
+    for (u32 stream_index = 0; stream_index < NUM_TEST_STREAMS; ++stream_index)
+    {
+        register_history_stream(history, stream_index, test_stream_names[stream_index]);
+    }
+
+    test_log.num_consumers = 0;
+    test_log.write_index = 0;
+    history->transition_consumer = register_transition_consumer(&test_log);
+}
+
+static void push_test_event(SessionHistory *history, TransitionEventType type, u32 stream_index, u64 time, char *game)
+{
+    TransitionEvent event = {};
+    event.type = type;
+    event.stream_index = stream_index;
+    event.time = time;
+    copy_string(game, event.game);
+
+    b32 pushed = push_transition_event(&test_log, &event);
+    assert(pushed);
+    update_session_history(history, &test_log);
+}
+
+// NOTE(dan): a session of a stream, sometimes split by a game change, ends one tick before the next one starts.
+// every 64th cycle ends without a flush
+static u64 add_test_sessions(SessionHistory *history, u32 count, u64 time, u32 *random_state, b32 track)
+{
+    for (u32 session_index = 0; session_index < count; ++session_index)
+    {
+        u32 random = next_test_random(random_state);
+        u32 stream_index = random % NUM_TEST_STREAMS;
+        u64 length = 1 + (random >> 8) % 20;
+
+        push_test_event(history, TransitionEventType_WentOnline, stream_index, time, (random & 0x100) ? (char *)"some game" : (char *)"another game");
+        if ((random & 0x1E00) == 0)
+        {
+            if (track)
+            {
+                TestSessions *sessions = test_sessions + stream_index;
+                sessions->sessions[sessions->count++] = {time, time + length};
+            }
+            time += length;
+            push_test_event(history, TransitionEventType_GameChanged, stream_index, time, "a third game");
+        }
+
+        if (track)
+        {
+            TestSessions *sessions = test_sessions + stream_index;
+            sessions->sessions[sessions->count++] = {time, time + length};
+        }
+        time += length;
+        push_test_event(history, TransitionEventType_WentOffline, stream_index, time, "");
+        time += 1 + (random >> 16) % 10;
+
+        if ((session_index % 16) == 15)
+        {
+            push_test_event(history, TransitionEventType_CycleEnd, 0, time, "");
+        }
+    }
+    return time;
+}
+
+// NOTE(dan): the same walk as find_session_at, counting the records it reads
+static u32 count_lookup_hops(SessionHistory *history, u32 stream_index, u64 time)
+{
+    u32 hops = 0;
+    SessionRecord *record = get_session_record(history, history->channels[history->stream_slots[stream_index]].last_seq);
+    while (record && record->start > time)
+    {
+        SessionRecord *jump = get_session_record(history, record->jump);
+        record = (jump && jump->start > time) ? jump : get_session_record(history, record->prev);
+        ++hops;
+    }
+    return hops;
+}
+
+static void check_lookups(SessionHistory *history, u32 num_queries, u32 *random_state)
+{
+    u32 num_wrong = 0;
+    u32 max_hops = 0;
+    for (u32 query_index = 0; query_index < num_queries; ++query_index)
+    {
+        u32 stream_index = next_test_random(random_state) % NUM_TEST_STREAMS;
+        TestSessions *sessions = test_sessions + stream_index;
+        TestSession *session = sessions->sessions + next_test_random(random_state) % sessions->count;
+
+        // NOTE(dan): inside the session, or in the gap after it
+        u64 time = session->start + next_test_random(random_state) % (session->end - session->start + 3);
+
+        TestSession *expected = 0;
+        for (u32 session_index = 0; session_index < sessions->count; ++session_index)
+        {
+            TestSession *test = sessions->sessions + session_index;
+            if (test->start <= time && time <= test->end)
+            {
+                // NOTE(dan): where a game change splits a session the later part is the one found
+                expected = test;
+            }
+        }
+
+        SessionRecord record;
+        b32 found = find_session_at(history, stream_index, time, &record);
+        if (found != (expected != 0) || (found && (record.start != expected->start || record.end != expected->end)))
+        {
+            ++num_wrong;
+        }
+
+        u32 hops = count_lookup_hops(history, stream_index, time);
+        max_hops = (hops > max_hops) ? hops : max_hops;
+    }
+    check(num_wrong == 0);
+
+    // NOTE(dan): skew binary jumps reach any record in under 3*log2(n) hops
+    u32 max_count = 0;
+    for (u32 stream_index = 0; stream_index < NUM_TEST_STREAMS; ++stream_index)
+    {
+        max_count = (test_sessions[stream_index].count > max_count) ? test_sessions[stream_index].count : max_count;
+    }
+    u32 log2_count = 0;
+    while (((u32)1 << log2_count) < max_count)
+    {
+        ++log2_count;
+    }
+    printf("%u sessions per stream, at most %u hops per lookup\n", max_count, max_hops);
+    check(max_hops <= 3*log2_count);
+}
+
+static void check_crash_recovery(u32 *random_state)
+{
+    static SessionHistory history;
+    static SessionHistory recovered;
+
+    reset_history_directory();
+    open_test_history(&history);
+    for (u32 stream_index = 0; stream_index < NUM_TEST_STREAMS; ++stream_index)
+    {
+        test_sessions[stream_index].count = 0;
+    }
+
+    u64 time = add_test_sessions(&history, 1000, 1000000, random_state, true);
+    push_test_event(&history, TransitionEventType_CycleEnd, 0, time, "");
+    u64 flushed_seq = history.flushed_seq;
+    check(flushed_seq == history.next_seq);
+
+    // NOTE(dan): five more sessions that never see a flush, the fourth one torn
+    u64 starts[5];
+    for (u32 session_index = 0; session_index < 5; ++session_index)
+    {
+        starts[session_index] = time;
+        push_test_event(&history, TransitionEventType_WentOnline, 1, time, "some game");
+        push_test_event(&history, TransitionEventType_WentOffline, 1, time + 5, "");
+        time += 10;
+    }
+    check(history.next_seq == flushed_seq + 5);
+    get_session_record(&history, flushed_seq + 3)->end += 1;
+
+    open_test_history(&recovered);
+    check(recovered.next_seq == flushed_seq + 3);
+
+    SessionRecord record;
+    b32 found = get_last_session(&recovered, 1, &record);
+    check(found && record.start == starts[2]);
+    check(recovered.last_sessions[1].start == starts[2] && recovered.last_sessions[1].end == starts[2] + 5);
+    check(recovered.channels[recovered.stream_slots[1]].last_seq == flushed_seq + 2);
+
+    for (u32 session_index = 0; session_index < 3; ++session_index)
+    {
+        TestSessions *sessions = test_sessions + 1;
+        sessions->sessions[sessions->count++] = {starts[session_index], starts[session_index] + 5};
+    }
+    check_lookups(&recovered, 2000, random_state);
+
+    // NOTE(dan): the torn record is written over by the next session
+    push_test_event(&recovered, TransitionEventType_WentOnline, 2, time, "some game");
+    push_test_event(&recovered, TransitionEventType_WentOffline, 2, time + 5, "");
+    push_test_event(&recovered, TransitionEventType_CycleEnd, 0, time + 5, "");
+    found = get_last_session(&recovered, 2, &record);
+    check(found && record.start == time);
+    check(recovered.last_sessions[2].start == time && recovered.last_sessions[2].end == time + 5);
+    check(recovered.next_seq == flushed_seq + 4);
+}
+
+static void check_compaction(u32 *random_state)
+{
+    static SessionHistory history;
+
+    reset_history_directory();
+    open_test_history(&history);
+
+    // NOTE(dan): game changes split some sessions, so this goes a few segments past the retention
+    u32 num_sessions = HISTORY_MAX_SEGMENTS*HISTORY_SEGMENT_RECORDS;
+    u32 flushes_before = test_num_flushes;
+    f64 start = get_test_seconds();
+    u64 time = add_test_sessions(&history, num_sessions, 1000000, random_state, false);
+    push_test_event(&history, TransitionEventType_CycleEnd, 0, time, "");
+    f64 seconds = get_test_seconds() - start;
+
+    u64 num_records = history.next_seq;
+    u32 num_flushes = test_num_flushes - flushes_before;
+    printf("%llu records in %.2f s, %.0f ns each, %u flushes\n", (unsigned long long)num_records, seconds,
+           seconds*1e9 / (f64)num_records, num_flushes);
+
+    // NOTE(dan): one flush per cycle, and one more for every segment filled up
+    u32 num_cycles = num_sessions / 16 + 1;
+    check(num_flushes <= num_cycles + (u32)(num_records / HISTORY_SEGMENT_RECORDS));
+
+    check(history.compaction_queued);
+    check(history.first_seq == 0);
+
+    // NOTE(dan): every segment goes but the active one and the HISTORY_MAX_SEGMENTS - 1 before it
+    u64 first_seq = (num_records/HISTORY_SEGMENT_RECORDS - (HISTORY_MAX_SEGMENTS - 1))*HISTORY_SEGMENT_RECORDS;
+    check(first_seq > 0);
+
+    u32 expected_expired[NUM_TEST_STREAMS] = {};
+    u64 expected_seconds[NUM_TEST_STREAMS] = {};
+    for (u64 seq = 0; seq < first_seq; ++seq)
+    {
+        SessionRecord *record = get_session_record(&history, seq);
+        for (u32 stream_index = 0; stream_index < NUM_TEST_STREAMS; ++stream_index)
+        {
+            if (record->channel_slot == history.stream_slots[stream_index])
+            {
+                ++expected_expired[stream_index];
+                expected_seconds[stream_index] += record->end - record->start;
+            }
+        }
+    }
+
+    test_complete_all_work(platform.low_priority_queue);
+    check(!history.compaction_queued);
+    check(history.first_seq == first_seq);
+    check(get_session_record(&history, first_seq - 1) == 0);
+    check(get_session_record(&history, first_seq) != 0);
+
+    char filename[HISTORY_MAX_PATH];
+    struct stat file_stat;
+    build_history_segment_filename(&history, 0, filename);
+    check(stat(filename, &file_stat) != 0);
+    build_history_segment_filename(&history, first_seq / HISTORY_SEGMENT_RECORDS - 1, filename);
+    check(stat(filename, &file_stat) != 0);
+    build_history_segment_filename(&history, first_seq / HISTORY_SEGMENT_RECORDS, filename);
+    check(stat(filename, &file_stat) == 0);
+
+    for (u32 stream_index = 0; stream_index < NUM_TEST_STREAMS; ++stream_index)
+    {
+        HistoryChannel *channel = history.channels + history.stream_slots[stream_index];
+        check(channel->expired_sessions == expected_expired[stream_index]);
+        check(channel->expired_seconds == expected_seconds[stream_index]);
+
+        // NOTE(dan): lookups before the retention find nothing instead of walking off the chain
+        SessionRecord record;
+        check(!find_session_at(&history, stream_index, 1000000, &record));
+        check(get_last_session(&history, stream_index, &record));
+    }
+
+    // NOTE(dan): the saved heads start past the deleted segments
+    push_test_event(&history, TransitionEventType_CycleEnd, 0, time, "");
+    static SessionHistory reopened;
+    open_test_history(&reopened);
+    check(reopened.first_seq == first_seq);
+    check(reopened.next_seq == history.next_seq);
+}
+
+int main(int argc, char **argv)
+{
+    init_test_platform();
+
+    u32 max_sessions = 40000;
+    for (u32 stream_index = 0; stream_index < NUM_TEST_STREAMS; ++stream_index)
+    {
+        test_sessions[stream_index].sessions = (TestSession *)malloc(max_sessions * sizeof(TestSession));
+    }
+
+    u32 random_state = 2024;
+    static SessionHistory history;
+    reset_history_directory();
+    open_test_history(&history);
+    add_test_sessions(&history, 15000, 1000000, &random_state, true);
+    check_lookups(&history, 5000, &random_state);
+
+    check_crash_recovery(&random_state);
+
+    // NOTE(dan): writes about 200MB, so it runs with the benchmarks
+    if (benchmarks_requested(argc, argv))
+    {
+        check_compaction(&random_state);
+    }
+
+    int result = system("rm -rf " TEST_HISTORY_PATH);
+    check(result == 0);
+    return end_test("session_history_test");
+}
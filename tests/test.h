@@ -0,0 +1,298 @@
+// NOTE(dan): the tests build the core the same way the app does, everything in one
+// translation unit, on top of a platform layer made of plain posix calls. they run
+// on linux and mac, see build.sh
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../src/platform.h"
+#include "../src/whosalive.cpp"
+
+Platform platform;
+
+static u32 test_checks;
+static u32 test_failures;
+
+#define check(e) do \
+{ \
+    ++test_checks; \
+    if (!(e)) \
+    { \
+        ++test_failures; \
+        printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #e); \
+    } \
+} while (0)
+
+// NOTE(dan): benchmarks only run when asked for, e.g. build.sh bench
+inline b32 benchmarks_requested(int argc, char **argv)
+{
+    b32 requested = (argc > 1) && strings_equal(argv[1], "bench");
+    return requested;
+}
+
+inline f64 get_test_seconds()
+{
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    f64 seconds = (f64)time.tv_sec + (f64)time.tv_nsec*1e-9;
+    return seconds;
+}
+
+inline u32 next_test_random(u32 *state)
+{
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int end_test(char *name)
+{
+    printf("%s: %u checks, %u failed\n", name, test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
+
+//
+// NOTE(dan): platform layer
+//
+
+static PLATFORM_LOAD_FILE(test_load_file)
+{
+    LoadedFile result = {};
+
+    FILE *file = fopen(filename, "rb");
+    if (file)
+    {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        result.contents = malloc(size ? size : 1);
+        if (result.contents && fread(result.contents, 1, size, file) == (size_t)size)
+        {
+            result.size = (u32)size;
+        }
+        else
+        {
+            free(result.contents);
+            result.contents = 0;
+        }
+        fclose(file);
+    }
+    return result;
+}
+
+static PLATFORM_UNLOAD_FILE(test_unload_file)
+{
+    free(file.contents);
+}
+
+static PLATFORM_WRITE_ENTIRE_FILE(test_write_entire_file)
+{
+    b32 result = false;
+
+    char temp_filename[512];
+    snprintf(temp_filename, array_count(temp_filename), "%s.tmp", filename);
+
+    FILE *file = fopen(temp_filename, "wb");
+    if (file)
+    {
+        b32 written = (fwrite(memory, 1, size, file) == size);
+        written = (fflush(file) == 0) && (fsync(fileno(file)) == 0) && written;
+        fclose(file);
+
+        result = written && (rename(temp_filename, filename) == 0);
+    }
+    return result;
+}
+
+static PLATFORM_MAP_FILE(test_map_file)
+{
+    b32 result = false;
+    *file = {};
+
+    int handle = open(filename, O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (handle >= 0)
+    {
+        struct stat file_stat;
+        if (fstat(handle, &file_stat) == 0 && ((u64)file_stat.st_size >= size || ftruncate(handle, (off_t)size) == 0))
+        {
+            void *memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+            if (memory != MAP_FAILED)
+            {
+                file->memory = memory;
+                file->size = size;
+                file->file_handle = (void *)(usize)handle;
+                result = true;
+            }
+        }
+
+        if (!result)
+        {
+            close(handle);
+        }
+    }
+    return result;
+}
+
+static PLATFORM_UNMAP_FILE(test_unmap_file)
+{
+    if (file->memory)
+    {
+        munmap(file->memory, file->size);
+        close((int)(usize)file->file_handle);
+    }
+    *file = {};
+}
+
+static u32 test_num_flushes;
+
+static PLATFORM_FLUSH_MAPPED_FILE(test_flush_mapped_file)
+{
+    if (file->memory && offset < file->size)
+    {
+        // NOTE(dan): msync wants a page aligned start
+        u64 page_offset = offset & ~(u64)4095;
+        msync((u8 *)file->memory + page_offset, size + (offset - page_offset), MS_SYNC);
+        ++test_num_flushes;
+    }
+}
+
+static PLATFORM_DELETE_FILE(test_delete_file)
+{
+    unlink(filename);
+}
+
+// NOTE(dan): work runs when the test completes it, the way a worker thread would
+// pick it up later, so a test can look at the state from before the work ran
+struct TestWork
+{
+    PlatformWorkQueueCallback *callback;
+    PlatformWorkQueue *queue;
+    void *data;
+};
+
+static u32 test_num_work;
+static TestWork test_work[64];
+
+static PLATFORM_ADD_WORK(test_add_work)
+{
+    assert(test_num_work < array_count(test_work));
+    TestWork *work = test_work + test_num_work++;
+    work->callback = callback;
+    work->queue = queue;
+    work->data = data;
+}
+
+static PLATFORM_COMPLETE_ALL_WORK(test_complete_all_work)
+{
+    for (u32 work_index = 0; work_index < test_num_work; ++work_index)
+    {
+        TestWork *work = test_work + work_index;
+        work->callback(work->queue, work->data);
+    }
+    test_num_work = 0;
+}
+
+static PLATFORM_COMPLETE_WORK_BEFORE(test_complete_work_before)
+{
+    return true;
+}
+
+static PLATFORM_SHOW_NOTIFICATIONS(test_show_notifications)
+{
+}
+
+static PLATFORM_SIGNAL_EVENTS(test_signal_events)
+{
+}
+
+static PLATFORM_CACHE_LOGO(test_cache_logo)
+{
+}
+
+// NOTE(dan): for the tests that draw cards
+#define TEST_LOGO_SIZE          60
+#define TEST_LOGO_FILE_SIZE     (sizeof(LogoFileHeader) + TEST_LOGO_SIZE * TEST_LOGO_SIZE * 4)
+
+static GlyphAtlas test_atlas;
+
+// NOTE(dan): every glyph is a different size and coverage pattern, so a glyph
+// drawn in the wrong spot or from the wrong place in the atlas changes the image
+static void bake_test_font(GlyphAtlas *atlas, FontId font_id, i32 height, i32 ascent)
+{
+    Font *font = atlas->fonts + font_id;
+    font->height = height;
+    font->ascent = ascent;
+
+    for (u32 c = FIRST_GLYPH; c <= LAST_GLYPH; ++c)
+    {
+        Glyph *glyph = font->glyphs + (c - FIRST_GLYPH);
+
+        u32 width = (c == ' ') ? 0 : 3 + (c % 5);
+        u32 glyph_height = (c == ' ') ? 0 : (u32)ascent - (c % 3);
+        glyph->offset_x = 1;
+        glyph->offset_y = (i16)glyph_height;
+        glyph->advance = (i16)(width + 2);
+
+        if (allocate_glyph(atlas, width, glyph_height, glyph))
+        {
+            for (u32 y = 0; y < glyph_height; ++y)
+            {
+                u8 *dest = atlas->coverage + (glyph->y + y) * GLYPH_ATLAS_WIDTH + glyph->x;
+                for (u32 x = 0; x < width; ++x)
+                {
+                    dest[x] = (u8)((x*71 + y*29 + c*13) & 0xFF);
+                }
+            }
+        }
+    }
+}
+
+// NOTE(dan): a gradient with see-through corners, through the same conversion a downloaded logo takes
+static void make_test_logo(void *file_memory, Logo *logo)
+{
+    static u8 image[TEST_LOGO_SIZE * TEST_LOGO_SIZE * 4];
+    for (u32 y = 0; y < TEST_LOGO_SIZE; ++y)
+    {
+        for (u32 x = 0; x < TEST_LOGO_SIZE; ++x)
+        {
+            u8 *pixel = image + (y*TEST_LOGO_SIZE + x)*4;
+            pixel[0] = (u8)(x*4);
+            pixel[1] = (u8)(y*4);
+            pixel[2] = (u8)((x + y)*2);
+            pixel[3] = (u8)(((x < 8) && (y < 8)) ? x*y*4 : 255);
+        }
+    }
+
+    LogoValidators validators = {};
+    write_logo_file(file_memory, image, 4, TEST_LOGO_SIZE, TEST_LOGO_SIZE, 0, &validators);
+    b32 parsed = parse_logo_file(file_memory, get_logo_file_size(TEST_LOGO_SIZE, TEST_LOGO_SIZE), logo);
+    check(parsed);
+}
+
+static void init_test_platform()
+{
+    platform.add_work = test_add_work;
+    platform.complete_all_work = test_complete_all_work;
+    platform.complete_work_before = test_complete_work_before;
+
+    platform.show_notifications = test_show_notifications;
+    platform.signal_events = test_signal_events;
+    platform.load_file = test_load_file;
+    platform.unload_file = test_unload_file;
+    platform.write_entire_file = test_write_entire_file;
+    platform.cache_logo = test_cache_logo;
+
+    platform.map_file = test_map_file;
+    platform.unmap_file = test_unmap_file;
+    platform.flush_mapped_file = test_flush_mapped_file;
+    platform.delete_file = test_delete_file;
+}
@@ -0,0 +1,176 @@
+// NOTE(dan): viewer samples against a plain list of every sample. single second
+// queries read each sample back, longer ones cut through blocks at random, and
+// the ring has to forget exactly the oldest blocks
+#include "test.h"
+
+#define MAX_TEST_SAMPLES    20000
+
+struct TestSamples
+{
+    u32 count;
+    u64 times[MAX_TEST_SAMPLES];
+    u32 viewers[MAX_TEST_SAMPLES];
+};
+
+static ViewerSeries test_series;
+static TestSamples test_samples;
+
+static void add_test_sample(u64 time, u32 viewers)
+{
+    append_viewer_sample(&test_series, time, viewers);
+
+    TestSamples *samples = &test_samples;
+    if (!samples->count || time > samples->times[samples->count - 1])
+    {
+        samples->times[samples->count] = time;
+        samples->viewers[samples->count] = viewers;
+        ++samples->count;
+    }
+}
+
+// NOTE(dan): polls a minute apart with the odd missed or late poll, and now and then a raid
+static void add_polled_samples(u32 count, u64 *time, u32 *viewers, u32 *random_state)
+{
+    for (u32 sample_index = 0; sample_index < count; ++sample_index)
+    {
+        u32 random = next_test_random(random_state);
+        *time += ((random % 10) == 0) ? 60*(1 + (random >> 4) % 4) : 60;
+        if (((random >> 8) % 50) == 0)
+        {
+            *time += (random >> 16) % 7;
+        }
+
+        i64 change = (i64)((random >> 12) % 201) - 100;
+        *viewers = ((i64)*viewers + change < 0) ? 0 : (u32)((i64)*viewers + change);
+        if (((random >> 20) % 500) == 0)
+        {
+            *viewers = next_test_random(random_state) % 1000000;
+        }
+        add_test_sample(*time, *viewers);
+    }
+}
+
+static u64 get_oldest_test_time()
+{
+    u64 oldest = 0;
+    if (test_series.num_blocks)
+    {
+        oldest = test_series.blocks[test_series.first_block].first_time;
+    }
+    return oldest;
+}
+
+static b32 viewer_stats_match(u64 from, u64 to)
+{
+    u64 oldest = get_oldest_test_time();
+
+    ViewerStats expected = {};
+    for (u32 sample_index = 0; sample_index < test_samples.count; ++sample_index)
+    {
+        u64 time = test_samples.times[sample_index];
+        if (time >= oldest && time >= from && time <= to)
+        {
+            u32 viewers = test_samples.viewers[sample_index];
+            ++expected.num_samples;
+            expected.sum_viewers += viewers;
+            expected.peak_viewers = (viewers > expected.peak_viewers) ? viewers : expected.peak_viewers;
+        }
+    }
+
+    ViewerStats stats = get_viewer_stats(&test_series, from, to);
+    return (stats.num_samples == expected.num_samples &&
+            stats.sum_viewers == expected.sum_viewers &&
+            stats.peak_viewers == expected.peak_viewers);
+}
+
+static void check_round_trip()
+{
+    memset(&test_series, 0, sizeof(test_series));
+    test_samples.count = 0;
+
+    // NOTE(dan): the extremes of every field, a gap too long for a block and samples out of order
+    add_test_sample(1000, 0);
+    add_test_sample(1001, 0xFFFFFFFF);
+    add_test_sample(1002, 0);
+    add_test_sample(1002, 55);
+    add_test_sample(999, 77);
+    add_test_sample(1062, 1);
+    add_test_sample(1062 + 0x100000000ULL, 2);
+    add_test_sample(1063 + 0x100000000ULL, 0x80000000);
+    add_test_sample(0xFFFFFFFFFFFFULL, 3);
+    check(test_samples.count == 7);
+
+    u32 random_state = 99;
+    u64 time = 0xFFFFFFFFFFFFULL;
+    u32 viewers = 3;
+    add_polled_samples(2000, &time, &viewers, &random_state);
+    check(test_series.num_blocks < VIEWER_BLOCKS_PER_STREAM);
+
+    u32 num_wrong = 0;
+    for (u32 sample_index = 0; sample_index < test_samples.count; ++sample_index)
+    {
+        u64 sample_time = test_samples.times[sample_index];
+        ViewerStats stats = get_viewer_stats(&test_series, sample_time, sample_time);
+        num_wrong += (stats.num_samples != 1 || stats.sum_viewers != test_samples.viewers[sample_index]);
+    }
+    check(num_wrong == 0);
+
+    // NOTE(dan): nothing comes back from the dropped samples
+    ViewerStats stats = get_viewer_stats(&test_series, 999, 999);
+    check(stats.num_samples == 0);
+    stats = get_viewer_stats(&test_series, 0, 1002);
+    check(stats.num_samples == 3 && stats.peak_viewers == 0xFFFFFFFF);
+}
+
+static void check_ring_and_ranges()
+{
+    memset(&test_series, 0, sizeof(test_series));
+    test_samples.count = 0;
+
+    u32 random_state = 4242;
+    u64 time = 1700000000;
+    u32 viewers = 5000;
+    add_polled_samples(MAX_TEST_SAMPLES, &time, &viewers, &random_state);
+
+    // NOTE(dan): the ring is full, it holds exactly the samples from its oldest block on
+    check(test_series.num_blocks == VIEWER_BLOCKS_PER_STREAM);
+    u64 oldest = get_oldest_test_time();
+    check(oldest > test_samples.times[0]);
+
+    u32 num_kept = 0;
+    u32 num_data_bytes = 0;
+    for (u32 block_index = 0; block_index < test_series.num_blocks; ++block_index)
+    {
+        num_kept += test_series.blocks[block_index].num_samples;
+        num_data_bytes += test_series.blocks[block_index].used;
+    }
+    ViewerStats all = get_viewer_stats(&test_series, 0, time);
+    check(all.num_samples == num_kept);
+    check(viewer_stats_match(0, time));
+    check(viewer_stats_match(0, oldest - 1));
+
+    // NOTE(dan): ranges that start and end inside blocks, sometimes both inside the same one
+    u32 num_wrong = 0;
+    for (u32 query_index = 0; query_index < 4000; ++query_index)
+    {
+        u32 sample_index = next_test_random(&random_state) % test_samples.count;
+        u64 from = test_samples.times[sample_index] - next_test_random(&random_state) % 100;
+        u64 to = from + ((query_index & 1) ? next_test_random(&random_state) % 2000 : next_test_random(&random_state) % 200000);
+        num_wrong += !viewer_stats_match(from, to);
+    }
+    check(num_wrong == 0);
+
+    printf("%u samples kept in %u blocks, %.2f data bytes per sample, %.2f bytes per sample with the block headers\n",
+           num_kept, test_series.num_blocks, (f64)num_data_bytes / (f64)num_kept, (f64)sizeof(ViewerSeries) / (f64)num_kept);
+    check((f64)num_data_bytes / (f64)num_kept < 3.0);
+}
+
+int main(int argc, char **argv)
+{
+    init_test_platform();
+
+    check_round_trip();
+    check_ring_and_ranges();
+
+    return end_test("viewer_series_test");
+}